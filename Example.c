@@ -24,6 +24,10 @@
 
 #define DELAY_MS 2000
 
+// Statically allocated storage for the second (8-bit) initialization, so
+// re-initializing the display doesn't need the heap
+static LCD_STORAGE(lcd_storage, LCD_COLS, LCD_ROWS);
+
 // Define a custom character (smiley face) for the LCD
 uint8_t smiley[8] = {0b00000, 0b10001, 0b00000, 0b00000,
                      0b10001, 0b01110, 0b00000, 0b00000};
@@ -62,10 +66,11 @@ int main() {
 
   sleep_ms(DELAY_MS / 2);
 
-  // Reinitialize the LCD in 8-bit mode
-  handle_1 = lcd_init_8bit(LCD_COLS, LCD_ROWS, LCD_5x8DOTS, LCD_RS, LCD_RW,
-                           LCD_EN, LCD_D0, LCD_D1, LCD_D2, LCD_D3, LCD_D4,
-                           LCD_D5, LCD_D6, LCD_D7);
+  // Reinitialize the LCD in 8-bit mode, this time in static storage
+  handle_1 = lcd_init_8bit_static(lcd_storage, sizeof(lcd_storage), LCD_COLS,
+                                  LCD_ROWS, LCD_5x8DOTS, LCD_RS, LCD_RW, LCD_EN,
+                                  LCD_D0, LCD_D1, LCD_D2, LCD_D3, LCD_D4,
+                                  LCD_D5, LCD_D6, LCD_D7);
 
   // Check if the LCD handle is NULL, which indicates that the initialization failed
   if (handle_1 == NULL) {
@@ -216,6 +221,6 @@ int main() {
 
   sleep_ms(DELAY_MS);
 
-  // Deinitialize the LCD (free resources)
+  // Deinitialize the LCD (the static storage can be reused afterwards)
   handle_1 = lcd_deinit(handle_1);
 }
@@ -21,18 +21,655 @@
 
 #include "pico/stdlib.h"
 
+// ########################################################################## //
+//                                                                            //
+//                             Bus configuration                              //
+//                                                                            //
+// ########################################################################## //
+
+// The transfer routines only look at the wiring through these macros. With
+// LCD_CONFIG_* fixed they become constants, the branches on them fold away
+// and the bus helpers are forced inline into _lcd_send_command/_lcd_send_data.
+
+#if LCD_CONFIG_BUS_WIDTH == 8
+#define _LCD_8BIT(handle) true
+#elif LCD_CONFIG_BUS_WIDTH == 4
+#define _LCD_8BIT(handle) false
+#else
+#define _LCD_8BIT(handle) (((handle)->_displayfunction & LCD_8BITMODE) != 0)
+#endif
+
+#if LCD_CONFIG_HAS_RW >= 0
+#define _LCD_HAS_RW(handle) (LCD_CONFIG_HAS_RW != 0)
+#else
+#define _LCD_HAS_RW(handle) ((handle)->_rw_pin != 255)
+#endif
+
+#if LCD_CONFIG_PINS
+#if LCD_CONFIG_HAS_RW
+#define _LCD_PIN_RW LCD_CONFIG_PIN_RW
+#else
+#define _LCD_PIN_RW 255
+#endif
+#if LCD_CONFIG_BUS_WIDTH == 8
+#define _LCD_PIN_DATA0 LCD_CONFIG_PIN_D0
+#define _LCD_PIN_DATA1 LCD_CONFIG_PIN_D1
+#define _LCD_PIN_DATA2 LCD_CONFIG_PIN_D2
+#define _LCD_PIN_DATA3 LCD_CONFIG_PIN_D3
+#define _LCD_PIN_DATA4 LCD_CONFIG_PIN_D4
+#define _LCD_PIN_DATA5 LCD_CONFIG_PIN_D5
+#define _LCD_PIN_DATA6 LCD_CONFIG_PIN_D6
+#define _LCD_PIN_DATA7 LCD_CONFIG_PIN_D7
+#define _LCD_DATA_MASK                                                     \
+  ((1u << _LCD_PIN_DATA0) | (1u << _LCD_PIN_DATA1) | (1u << _LCD_PIN_DATA2) | \
+   (1u << _LCD_PIN_DATA3) | (1u << _LCD_PIN_DATA4) | (1u << _LCD_PIN_DATA5) | \
+   (1u << _LCD_PIN_DATA6) | (1u << _LCD_PIN_DATA7))
+#define _LCD_SPREAD(data)                                                    \
+  ((((uint32_t)(data) >> 0) & 1u) << _LCD_PIN_DATA0 |                        \
+   (((uint32_t)(data) >> 1) & 1u) << _LCD_PIN_DATA1 |                        \
+   (((uint32_t)(data) >> 2) & 1u) << _LCD_PIN_DATA2 |                        \
+   (((uint32_t)(data) >> 3) & 1u) << _LCD_PIN_DATA3 |                        \
+   (((uint32_t)(data) >> 4) & 1u) << _LCD_PIN_DATA4 |                        \
+   (((uint32_t)(data) >> 5) & 1u) << _LCD_PIN_DATA5 |                        \
+   (((uint32_t)(data) >> 6) & 1u) << _LCD_PIN_DATA6 |                        \
+   (((uint32_t)(data) >> 7) & 1u) << _LCD_PIN_DATA7)
+#define _LCD_GATHER(all)                      \
+  ((((all) >> _LCD_PIN_DATA0) & 1u) << 0 |    \
+   (((all) >> _LCD_PIN_DATA1) & 1u) << 1 |    \
+   (((all) >> _LCD_PIN_DATA2) & 1u) << 2 |    \
+   (((all) >> _LCD_PIN_DATA3) & 1u) << 3 |    \
+   (((all) >> _LCD_PIN_DATA4) & 1u) << 4 |    \
+   (((all) >> _LCD_PIN_DATA5) & 1u) << 5 |    \
+   (((all) >> _LCD_PIN_DATA6) & 1u) << 6 |    \
+   (((all) >> _LCD_PIN_DATA7) & 1u) << 7)
+#else
+// on a 4-bit bus the controller's D4-D7 are the library's data lines 0-3
+#define _LCD_PIN_DATA0 LCD_CONFIG_PIN_D4
+#define _LCD_PIN_DATA1 LCD_CONFIG_PIN_D5
+#define _LCD_PIN_DATA2 LCD_CONFIG_PIN_D6
+#define _LCD_PIN_DATA3 LCD_CONFIG_PIN_D7
+#define _LCD_DATA_MASK                                                     \
+  ((1u << _LCD_PIN_DATA0) | (1u << _LCD_PIN_DATA1) | (1u << _LCD_PIN_DATA2) | \
+   (1u << _LCD_PIN_DATA3))
+#define _LCD_SPREAD(data)                             \
+  ((((uint32_t)(data) >> 0) & 1u) << _LCD_PIN_DATA0 | \
+   (((uint32_t)(data) >> 1) & 1u) << _LCD_PIN_DATA1 | \
+   (((uint32_t)(data) >> 2) & 1u) << _LCD_PIN_DATA2 | \
+   (((uint32_t)(data) >> 3) & 1u) << _LCD_PIN_DATA3)
+#define _LCD_GATHER(all)                      \
+  ((((all) >> _LCD_PIN_DATA0) & 1u) << 0 |    \
+   (((all) >> _LCD_PIN_DATA1) & 1u) << 1 |    \
+   (((all) >> _LCD_PIN_DATA2) & 1u) << 2 |    \
+   (((all) >> _LCD_PIN_DATA3) & 1u) << 3)
+#endif
+#define _LCD_RS_PIN(handle) LCD_CONFIG_PIN_RS
+#define _LCD_RW_PIN(handle) _LCD_PIN_RW
+#define _LCD_EN_PIN(handle) LCD_CONFIG_PIN_EN
+#define _LCD_DATA_PINS_MASK(handle) _LCD_DATA_MASK
+#else
+#define _LCD_RS_PIN(handle) ((handle)->_rs_pin)
+#define _LCD_RW_PIN(handle) ((handle)->_rw_pin)
+#define _LCD_EN_PIN(handle) ((handle)->_enable_pin)
+#define _LCD_DATA_PINS_MASK(handle) ((handle)->_data_pins_mask)
+#endif
+
+#if LCD_CONFIG_BUS_WIDTH && LCD_CONFIG_HAS_RW >= 0 && LCD_CONFIG_PINS
+#define _LCD_BUS_INLINE static inline __attribute__((always_inline))
+#else
+#define _LCD_BUS_INLINE
+#endif
+
+// The transfer routines also run from the alarms of lcd_init_async() and
+// lcd_animate(), in interrupt context where sleep_us() must not be called, so
+// they always busy-wait. With LCD_CONFIG_RUN_FROM_RAM the transfer and flush
+// routines are copied to SRAM and spin on the timer, because busy_wait_us_32()
+// runs from flash. Nothing they call may live in flash, so they only use inline
+// SDK helpers.
+#if LCD_CONFIG_RUN_FROM_RAM
+#define _LCD_RAM_FUNC(func_name) __not_in_flash_func(func_name)
+#define _LCD_SLEEP_US(us) _lcd_spin_us(us)
+
+static inline void _lcd_spin_us(uint32_t us) {
+  const uint32_t start = time_us_32();
+  while (time_us_32() - start <= us) {
+  }
+}
+#else
+#define _LCD_RAM_FUNC(func_name) func_name
+#define _LCD_SLEEP_US(us) busy_wait_us_32(us)
+#endif
+
+// Time lcd_clear() waits for the display to clear, in microseconds
+#define _LCD_CLEAR_US 5000
+
+// Attribute of cells whose frame buffer byte is an index into the planned
+// glyphs (_plan_codepoints) instead of a character code
+#define _LCD_ATTR_GLYPH 0x80
+
+// Steps of the initialization sequence, see _lcd_init_step()
+enum {
+  _LCD_INIT_FUNCTIONSET_1,
+  _LCD_INIT_FUNCTIONSET_2,
+  _LCD_INIT_FUNCTIONSET_3,
+  _LCD_INIT_INTERFACE,
+  _LCD_INIT_CONFIGURE,
+  _LCD_INIT_CLEARING,
+  _LCD_INIT_READY
+};
+
+// ########################################################################## //
+//                                                                            //
+//                              Character tables                              //
+//                                                                            //
+// ########################################################################## //
+
+// Character ROM codes (or an ASCII replacement) of a Unicode code point, the
+// second code is 0 if one is enough.
+typedef struct {
+  uint16_t codepoint;
+  uint8_t codes[2];
+} _LCD_RomEntry;
+
+// Pixel rows of a character drawn into CGRAM by the glyph cache.
+typedef struct {
+  uint16_t codepoint;
+  uint8_t rows[8];
+} _LCD_Glyph;
+
+// The tables are sorted by code point. Edit tools/lcd_romgen.py and run it
+// with --update instead of changing them here.
+
+// BEGIN lcd_romgen.py, generated by tools/lcd_romgen.py
+
+// A00 (Japanese) ROM codes of non-ASCII characters
+static const _LCD_RomEntry _lcd_rom_a00[] = {
+    {0x00A2, {0xEC, 0x00}}, {0x00A3, {0xED, 0x00}}, {0x00A5, {0x5C, 0x00}},
+    {0x00B0, {0xDF, 0x00}}, {0x00B5, {0xE4, 0x00}}, {0x00DF, {0xE2, 0x00}},
+    {0x00E4, {0xE1, 0x00}}, {0x00F1, {0xEE, 0x00}}, {0x00F6, {0xEF, 0x00}},
+    {0x00F7, {0xFD, 0x00}}, {0x00FC, {0xF5, 0x00}}, {0x03A3, {0xF6, 0x00}},
+    {0x03A9, {0xF4, 0x00}}, {0x03B1, {0xE0, 0x00}}, {0x03B2, {0xE2, 0x00}},
+    {0x03B5, {0xE3, 0x00}}, {0x03B8, {0xF2, 0x00}}, {0x03BC, {0xE4, 0x00}},
+    {0x03C0, {0xF7, 0x00}}, {0x03C1, {0xE6, 0x00}}, {0x03C3, {0xE5, 0x00}},
+    {0x2126, {0xF4, 0x00}}, {0x2190, {0x7F, 0x00}}, {0x2192, {0x7E, 0x00}},
+    {0x221A, {0xE8, 0x00}}, {0x221E, {0xF3, 0x00}}, {0x2588, {0xFF, 0x00}},
+    {0x3001, {0xA4, 0x00}}, {0x3002, {0xA1, 0x00}}, {0x300C, {0xA2, 0x00}},
+    {0x300D, {0xA3, 0x00}}, {0x3041, {0xA7, 0x00}}, {0x3042, {0xB1, 0x00}},
+    {0x3043, {0xA8, 0x00}}, {0x3044, {0xB2, 0x00}}, {0x3045, {0xA9, 0x00}},
+    {0x3046, {0xB3, 0x00}}, {0x3047, {0xAA, 0x00}}, {0x3048, {0xB4, 0x00}},
+    {0x3049, {0xAB, 0x00}}, {0x304A, {0xB5, 0x00}}, {0x304B, {0xB6, 0x00}},
+    {0x304C, {0xB6, 0xDE}}, {0x304D, {0xB7, 0x00}}, {0x304E, {0xB7, 0xDE}},
+    {0x304F, {0xB8, 0x00}}, {0x3050, {0xB8, 0xDE}}, {0x3051, {0xB9, 0x00}},
+    {0x3052, {0xB9, 0xDE}}, {0x3053, {0xBA, 0x00}}, {0x3054, {0xBA, 0xDE}},
+    {0x3055, {0xBB, 0x00}}, {0x3056, {0xBB, 0xDE}}, {0x3057, {0xBC, 0x00}},
+    {0x3058, {0xBC, 0xDE}}, {0x3059, {0xBD, 0x00}}, {0x305A, {0xBD, 0xDE}},
+    {0x305B, {0xBE, 0x00}}, {0x305C, {0xBE, 0xDE}}, {0x305D, {0xBF, 0x00}},
+    {0x305E, {0xBF, 0xDE}}, {0x305F, {0xC0, 0x00}}, {0x3060, {0xC0, 0xDE}},
+    {0x3061, {0xC1, 0x00}}, {0x3062, {0xC1, 0xDE}}, {0x3063, {0xAF, 0x00}},
+    {0x3064, {0xC2, 0x00}}, {0x3065, {0xC2, 0xDE}}, {0x3066, {0xC3, 0x00}},
+    {0x3067, {0xC3, 0xDE}}, {0x3068, {0xC4, 0x00}}, {0x3069, {0xC4, 0xDE}},
+    {0x306A, {0xC5, 0x00}}, {0x306B, {0xC6, 0x00}}, {0x306C, {0xC7, 0x00}},
+    {0x306D, {0xC8, 0x00}}, {0x306E, {0xC9, 0x00}}, {0x306F, {0xCA, 0x00}},
+    {0x3070, {0xCA, 0xDE}}, {0x3071, {0xCA, 0xDF}}, {0x3072, {0xCB, 0x00}},
+    {0x3073, {0xCB, 0xDE}}, {0x3074, {0xCB, 0xDF}}, {0x3075, {0xCC, 0x00}},
+    {0x3076, {0xCC, 0xDE}}, {0x3077, {0xCC, 0xDF}}, {0x3078, {0xCD, 0x00}},
+    {0x3079, {0xCD, 0xDE}}, {0x307A, {0xCD, 0xDF}}, {0x307B, {0xCE, 0x00}},
+    {0x307C, {0xCE, 0xDE}}, {0x307D, {0xCE, 0xDF}}, {0x307E, {0xCF, 0x00}},
+    {0x307F, {0xD0, 0x00}}, {0x3080, {0xD1, 0x00}}, {0x3081, {0xD2, 0x00}},
+    {0x3082, {0xD3, 0x00}}, {0x3083, {0xAC, 0x00}}, {0x3084, {0xD4, 0x00}},
+    {0x3085, {0xAD, 0x00}}, {0x3086, {0xD5, 0x00}}, {0x3087, {0xAE, 0x00}},
+    {0x3088, {0xD6, 0x00}}, {0x3089, {0xD7, 0x00}}, {0x308A, {0xD8, 0x00}},
+    {0x308B, {0xD9, 0x00}}, {0x308C, {0xDA, 0x00}}, {0x308D, {0xDB, 0x00}},
+    {0x308E, {0xDC, 0x00}}, {0x308F, {0xDC, 0x00}}, {0x3090, {0xB2, 0x00}},
+    {0x3091, {0xB4, 0x00}}, {0x3092, {0xA6, 0x00}}, {0x3093, {0xDD, 0x00}},
+    {0x3094, {0xB3, 0xDE}}, {0x3095, {0xB6, 0x00}}, {0x3096, {0xB9, 0x00}},
+    {0x30A1, {0xA7, 0x00}}, {0x30A2, {0xB1, 0x00}}, {0x30A3, {0xA8, 0x00}},
+    {0x30A4, {0xB2, 0x00}}, {0x30A5, {0xA9, 0x00}}, {0x30A6, {0xB3, 0x00}},
+    {0x30A7, {0xAA, 0x00}}, {0x30A8, {0xB4, 0x00}}, {0x30A9, {0xAB, 0x00}},
+    {0x30AA, {0xB5, 0x00}}, {0x30AB, {0xB6, 0x00}}, {0x30AC, {0xB6, 0xDE}},
+    {0x30AD, {0xB7, 0x00}}, {0x30AE, {0xB7, 0xDE}}, {0x30AF, {0xB8, 0x00}},
+    {0x30B0, {0xB8, 0xDE}}, {0x30B1, {0xB9, 0x00}}, {0x30B2, {0xB9, 0xDE}},
+    {0x30B3, {0xBA, 0x00}}, {0x30B4, {0xBA, 0xDE}}, {0x30B5, {0xBB, 0x00}},
+    {0x30B6, {0xBB, 0xDE}}, {0x30B7, {0xBC, 0x00}}, {0x30B8, {0xBC, 0xDE}},
+    {0x30B9, {0xBD, 0x00}}, {0x30BA, {0xBD, 0xDE}}, {0x30BB, {0xBE, 0x00}},
+    {0x30BC, {0xBE, 0xDE}}, {0x30BD, {0xBF, 0x00}}, {0x30BE, {0xBF, 0xDE}},
+    {0x30BF, {0xC0, 0x00}}, {0x30C0, {0xC0, 0xDE}}, {0x30C1, {0xC1, 0x00}},
+    {0x30C2, {0xC1, 0xDE}}, {0x30C3, {0xAF, 0x00}}, {0x30C4, {0xC2, 0x00}},
+    {0x30C5, {0xC2, 0xDE}}, {0x30C6, {0xC3, 0x00}}, {0x30C7, {0xC3, 0xDE}},
+    {0x30C8, {0xC4, 0x00}}, {0x30C9, {0xC4, 0xDE}}, {0x30CA, {0xC5, 0x00}},
+    {0x30CB, {0xC6, 0x00}}, {0x30CC, {0xC7, 0x00}}, {0x30CD, {0xC8, 0x00}},
+    {0x30CE, {0xC9, 0x00}}, {0x30CF, {0xCA, 0x00}}, {0x30D0, {0xCA, 0xDE}},
+    {0x30D1, {0xCA, 0xDF}}, {0x30D2, {0xCB, 0x00}}, {0x30D3, {0xCB, 0xDE}},
+    {0x30D4, {0xCB, 0xDF}}, {0x30D5, {0xCC, 0x00}}, {0x30D6, {0xCC, 0xDE}},
+    {0x30D7, {0xCC, 0xDF}}, {0x30D8, {0xCD, 0x00}}, {0x30D9, {0xCD, 0xDE}},
+    {0x30DA, {0xCD, 0xDF}}, {0x30DB, {0xCE, 0x00}}, {0x30DC, {0xCE, 0xDE}},
+    {0x30DD, {0xCE, 0xDF}}, {0x30DE, {0xCF, 0x00}}, {0x30DF, {0xD0, 0x00}},
+    {0x30E0, {0xD1, 0x00}}, {0x30E1, {0xD2, 0x00}}, {0x30E2, {0xD3, 0x00}},
+    {0x30E3, {0xAC, 0x00}}, {0x30E4, {0xD4, 0x00}}, {0x30E5, {0xAD, 0x00}},
+    {0x30E6, {0xD5, 0x00}}, {0x30E7, {0xAE, 0x00}}, {0x30E8, {0xD6, 0x00}},
+    {0x30E9, {0xD7, 0x00}}, {0x30EA, {0xD8, 0x00}}, {0x30EB, {0xD9, 0x00}},
+    {0x30EC, {0xDA, 0x00}}, {0x30ED, {0xDB, 0x00}}, {0x30EE, {0xDC, 0x00}},
+    {0x30EF, {0xDC, 0x00}}, {0x30F0, {0xB2, 0x00}}, {0x30F1, {0xB4, 0x00}},
+    {0x30F2, {0xA6, 0x00}}, {0x30F3, {0xDD, 0x00}}, {0x30F4, {0xB3, 0xDE}},
+    {0x30F5, {0xB6, 0x00}}, {0x30F6, {0xB9, 0x00}}, {0x30F7, {0xDC, 0xDE}},
+    {0x30FA, {0xA6, 0xDE}}, {0x30FB, {0xA5, 0x00}}, {0x30FC, {0xB0, 0x00}},
+    {0x4E07, {0xFB, 0x00}}, {0x5186, {0xFC, 0x00}}, {0x5343, {0xFA, 0x00}},
+};
+
+// A02 (European) ROM codes of non-ASCII characters
+static const _LCD_RomEntry _lcd_rom_a02[] = {
+    {0x00A0, {0xA0, 0x00}}, {0x00A1, {0xA1, 0x00}}, {0x00A2, {0xA2, 0x00}},
+    {0x00A3, {0xA3, 0x00}}, {0x00A4, {0xA4, 0x00}}, {0x00A5, {0xA5, 0x00}},
+    {0x00A6, {0xA6, 0x00}}, {0x00A7, {0xA7, 0x00}}, {0x00A9, {0xA9, 0x00}},
+    {0x00AA, {0xAA, 0x00}}, {0x00AB, {0xAB, 0x00}}, {0x00AE, {0xAE, 0x00}},
+    {0x00B0, {0xB0, 0x00}}, {0x00B1, {0xB1, 0x00}}, {0x00B2, {0xB2, 0x00}},
+    {0x00B3, {0xB3, 0x00}}, {0x00B5, {0xB5, 0x00}}, {0x00B6, {0xB6, 0x00}},
+    {0x00B7, {0xB7, 0x00}}, {0x00B9, {0xB9, 0x00}}, {0x00BA, {0xBA, 0x00}},
+    {0x00BB, {0xBB, 0x00}}, {0x00BC, {0xBC, 0x00}}, {0x00BD, {0xBD, 0x00}},
+    {0x00BE, {0xBE, 0x00}}, {0x00BF, {0xBF, 0x00}}, {0x00C0, {0xC0, 0x00}},
+    {0x00C1, {0xC1, 0x00}}, {0x00C2, {0xC2, 0x00}}, {0x00C3, {0xC3, 0x00}},
+    {0x00C4, {0xC4, 0x00}}, {0x00C5, {0xC5, 0x00}}, {0x00C6, {0xC6, 0x00}},
+    {0x00C7, {0xC7, 0x00}}, {0x00C8, {0xC8, 0x00}}, {0x00C9, {0xC9, 0x00}},
+    {0x00CA, {0xCA, 0x00}}, {0x00CB, {0xCB, 0x00}}, {0x00CC, {0xCC, 0x00}},
+    {0x00CD, {0xCD, 0x00}}, {0x00CE, {0xCE, 0x00}}, {0x00CF, {0xCF, 0x00}},
+    {0x00D0, {0xD0, 0x00}}, {0x00D1, {0xD1, 0x00}}, {0x00D2, {0xD2, 0x00}},
+    {0x00D3, {0xD3, 0x00}}, {0x00D4, {0xD4, 0x00}}, {0x00D5, {0xD5, 0x00}},
+    {0x00D6, {0xD6, 0x00}}, {0x00D7, {0xD7, 0x00}}, {0x00D9, {0xD9, 0x00}},
+    {0x00DA, {0xDA, 0x00}}, {0x00DB, {0xDB, 0x00}}, {0x00DC, {0xDC, 0x00}},
+    {0x00DD, {0xDD, 0x00}}, {0x00DE, {0xDE, 0x00}}, {0x00DF, {0xDF, 0x00}},
+    {0x00E0, {0xE0, 0x00}}, {0x00E1, {0xE1, 0x00}}, {0x00E2, {0xE2, 0x00}},
+    {0x00E3, {0xE3, 0x00}}, {0x00E4, {0xE4, 0x00}}, {0x00E5, {0xE5, 0x00}},
+    {0x00E6, {0xE6, 0x00}}, {0x00E7, {0xE7, 0x00}}, {0x00E8, {0xE8, 0x00}},
+    {0x00E9, {0xE9, 0x00}}, {0x00EA, {0xEA, 0x00}}, {0x00EB, {0xEB, 0x00}},
+    {0x00EC, {0xEC, 0x00}}, {0x00ED, {0xED, 0x00}}, {0x00EE, {0xEE, 0x00}},
+    {0x00EF, {0xEF, 0x00}}, {0x00F0, {0xF0, 0x00}}, {0x00F1, {0xF1, 0x00}},
+    {0x00F2, {0xF2, 0x00}}, {0x00F3, {0xF3, 0x00}}, {0x00F4, {0xF4, 0x00}},
+    {0x00F5, {0xF5, 0x00}}, {0x00F6, {0xF6, 0x00}}, {0x00F7, {0xF7, 0x00}},
+    {0x00F9, {0xF9, 0x00}}, {0x00FA, {0xFA, 0x00}}, {0x00FB, {0xFB, 0x00}},
+    {0x00FC, {0xFC, 0x00}}, {0x00FD, {0xFD, 0x00}}, {0x00FE, {0xFE, 0x00}},
+    {0x00FF, {0xFF, 0x00}}, {0x201C, {0x12, 0x00}}, {0x201D, {0x13, 0x00}},
+    {0x2190, {0x1B, 0x00}}, {0x2191, {0x18, 0x00}}, {0x2192, {0x1A, 0x00}},
+    {0x2193, {0x19, 0x00}}, {0x2264, {0x1C, 0x00}}, {0x2265, {0x1D, 0x00}},
+    {0x2302, {0x7F, 0x00}}, {0x25B2, {0x1E, 0x00}}, {0x25B6, {0x10, 0x00}},
+    {0x25BC, {0x1F, 0x00}}, {0x25C0, {0x11, 0x00}},
+};
+
+// Bitmaps drawn into CGRAM for characters missing from the ROM
+static const _LCD_Glyph _lcd_glyphs[] = {
+    {0x005C, {0x10, 0x10, 0x08, 0x04, 0x02, 0x01, 0x01, 0x00}},
+    {0x007E, {0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00}},
+    {0x00C1, {0x02, 0x04, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00}},
+    {0x00C4, {0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00}},
+    {0x00C7, {0x0E, 0x11, 0x10, 0x10, 0x11, 0x0E, 0x04, 0x0C}},
+    {0x00C9, {0x02, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x1F, 0x00}},
+    {0x00CD, {0x02, 0x04, 0x0E, 0x04, 0x04, 0x04, 0x0E, 0x00}},
+    {0x00D3, {0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00D4, {0x04, 0x0A, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00D6, {0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00DA, {0x02, 0x04, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00DC, {0x0A, 0x00, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00DD, {0x02, 0x04, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x00}},
+    {0x00E0, {0x08, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00}},
+    {0x00E1, {0x02, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00}},
+    {0x00E7, {0x00, 0x0E, 0x10, 0x11, 0x0E, 0x04, 0x0C, 0x00}},
+    {0x00E8, {0x08, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00}},
+    {0x00E9, {0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00}},
+    {0x00ED, {0x02, 0x04, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00}},
+    {0x00F3, {0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00F4, {0x04, 0x0A, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x00FA, {0x02, 0x04, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00}},
+    {0x00FD, {0x02, 0x04, 0x11, 0x11, 0x0F, 0x01, 0x0E, 0x00}},
+    {0x0104, {0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x02, 0x03}},
+    {0x0105, {0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x02, 0x03}},
+    {0x0106, {0x02, 0x04, 0x0E, 0x11, 0x10, 0x11, 0x0E, 0x00}},
+    {0x0107, {0x02, 0x04, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00}},
+    {0x010C, {0x0A, 0x04, 0x0E, 0x11, 0x10, 0x11, 0x0E, 0x00}},
+    {0x010D, {0x0A, 0x04, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00}},
+    {0x010E, {0x0A, 0x04, 0x1C, 0x12, 0x11, 0x12, 0x1C, 0x00}},
+    {0x010F, {0x03, 0x03, 0x0E, 0x12, 0x12, 0x12, 0x0E, 0x00}},
+    {0x0118, {0x1F, 0x10, 0x10, 0x1E, 0x10, 0x1F, 0x02, 0x03}},
+    {0x0119, {0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x04, 0x06}},
+    {0x011A, {0x0A, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x1F, 0x00}},
+    {0x011B, {0x0A, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00}},
+    {0x0139, {0x02, 0x04, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00}},
+    {0x013A, {0x02, 0x04, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00}},
+    {0x013D, {0x12, 0x12, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00}},
+    {0x013E, {0x0D, 0x05, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00}},
+    {0x0141, {0x10, 0x10, 0x14, 0x18, 0x10, 0x10, 0x1F, 0x00}},
+    {0x0142, {0x0C, 0x04, 0x05, 0x06, 0x0C, 0x04, 0x0E, 0x00}},
+    {0x0143, {0x02, 0x04, 0x11, 0x19, 0x15, 0x13, 0x11, 0x00}},
+    {0x0144, {0x02, 0x04, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00}},
+    {0x0147, {0x0A, 0x04, 0x11, 0x19, 0x15, 0x13, 0x11, 0x00}},
+    {0x0148, {0x0A, 0x04, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00}},
+    {0x0150, {0x05, 0x0A, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x0151, {0x05, 0x0A, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x0154, {0x02, 0x04, 0x1E, 0x11, 0x1E, 0x12, 0x11, 0x00}},
+    {0x0155, {0x02, 0x04, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00}},
+    {0x0158, {0x0A, 0x04, 0x1E, 0x11, 0x1E, 0x12, 0x11, 0x00}},
+    {0x0159, {0x0A, 0x04, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00}},
+    {0x015A, {0x02, 0x04, 0x0F, 0x10, 0x0E, 0x01, 0x1E, 0x00}},
+    {0x015B, {0x02, 0x04, 0x0E, 0x10, 0x0E, 0x01, 0x1E, 0x00}},
+    {0x0160, {0x0A, 0x04, 0x0F, 0x10, 0x0E, 0x01, 0x1E, 0x00}},
+    {0x0161, {0x0A, 0x04, 0x0E, 0x10, 0x0E, 0x01, 0x1E, 0x00}},
+    {0x0164, {0x0A, 0x04, 0x1F, 0x04, 0x04, 0x04, 0x04, 0x00}},
+    {0x0165, {0x09, 0x09, 0x1C, 0x08, 0x08, 0x09, 0x06, 0x00}},
+    {0x016E, {0x04, 0x0A, 0x04, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x016F, {0x04, 0x0A, 0x04, 0x11, 0x11, 0x13, 0x0D, 0x00}},
+    {0x0170, {0x05, 0x0A, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00}},
+    {0x0171, {0x05, 0x0A, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00}},
+    {0x0179, {0x02, 0x04, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}},
+    {0x017A, {0x02, 0x04, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}},
+    {0x017B, {0x04, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}},
+    {0x017C, {0x04, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}},
+    {0x017D, {0x0A, 0x04, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}},
+    {0x017E, {0x0A, 0x04, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00}},
+    {0x03A9, {0x00, 0x0E, 0x11, 0x11, 0x11, 0x0A, 0x1B, 0x00}},
+    {0x20AC, {0x06, 0x09, 0x1C, 0x08, 0x1C, 0x09, 0x06, 0x00}},
+};
+
+// ASCII replacements if neither ROM nor CGRAM can help
+static const _LCD_RomEntry _lcd_transliterations[] = {
+    {0x00A0, {0x20, 0x00}}, {0x00A1, {0x21, 0x00}}, {0x00A2, {0x63, 0x00}},
+    {0x00A3, {0x4C, 0x00}}, {0x00A5, {0x59, 0x00}}, {0x00A7, {0x53, 0x00}},
+    {0x00A9, {0x43, 0x00}}, {0x00AB, {0x3C, 0x3C}}, {0x00AE, {0x52, 0x00}},
+    {0x00B0, {0x6F, 0x00}}, {0x00B1, {0x2B, 0x2D}}, {0x00B2, {0x32, 0x00}},
+    {0x00B3, {0x33, 0x00}}, {0x00B5, {0x75, 0x00}}, {0x00B7, {0x2E, 0x00}},
+    {0x00B9, {0x31, 0x00}}, {0x00BB, {0x3E, 0x3E}}, {0x00BF, {0x3F, 0x00}},
+    {0x00C0, {0x41, 0x00}}, {0x00C1, {0x41, 0x00}}, {0x00C2, {0x41, 0x00}},
+    {0x00C3, {0x41, 0x00}}, {0x00C4, {0x41, 0x00}}, {0x00C5, {0x41, 0x00}},
+    {0x00C6, {0x41, 0x45}}, {0x00C7, {0x43, 0x00}}, {0x00C8, {0x45, 0x00}},
+    {0x00C9, {0x45, 0x00}}, {0x00CA, {0x45, 0x00}}, {0x00CB, {0x45, 0x00}},
+    {0x00CC, {0x49, 0x00}}, {0x00CD, {0x49, 0x00}}, {0x00CE, {0x49, 0x00}},
+    {0x00CF, {0x49, 0x00}}, {0x00D0, {0x44, 0x00}}, {0x00D1, {0x4E, 0x00}},
+    {0x00D2, {0x4F, 0x00}}, {0x00D3, {0x4F, 0x00}}, {0x00D4, {0x4F, 0x00}},
+    {0x00D5, {0x4F, 0x00}}, {0x00D6, {0x4F, 0x00}}, {0x00D7, {0x78, 0x00}},
+    {0x00D8, {0x4F, 0x00}}, {0x00D9, {0x55, 0x00}}, {0x00DA, {0x55, 0x00}},
+    {0x00DB, {0x55, 0x00}}, {0x00DC, {0x55, 0x00}}, {0x00DD, {0x59, 0x00}},
+    {0x00DE, {0x54, 0x68}}, {0x00DF, {0x73, 0x73}}, {0x00E0, {0x61, 0x00}},
+    {0x00E1, {0x61, 0x00}}, {0x00E2, {0x61, 0x00}}, {0x00E3, {0x61, 0x00}},
+    {0x00E4, {0x61, 0x00}}, {0x00E5, {0x61, 0x00}}, {0x00E6, {0x61, 0x65}},
+    {0x00E7, {0x63, 0x00}}, {0x00E8, {0x65, 0x00}}, {0x00E9, {0x65, 0x00}},
+    {0x00EA, {0x65, 0x00}}, {0x00EB, {0x65, 0x00}}, {0x00EC, {0x69, 0x00}},
+    {0x00ED, {0x69, 0x00}}, {0x00EE, {0x69, 0x00}}, {0x00EF, {0x69, 0x00}},
+    {0x00F0, {0x64, 0x00}}, {0x00F1, {0x6E, 0x00}}, {0x00F2, {0x6F, 0x00}},
+    {0x00F3, {0x6F, 0x00}}, {0x00F4, {0x6F, 0x00}}, {0x00F5, {0x6F, 0x00}},
+    {0x00F6, {0x6F, 0x00}}, {0x00F7, {0x3A, 0x00}}, {0x00F8, {0x6F, 0x00}},
+    {0x00F9, {0x75, 0x00}}, {0x00FA, {0x75, 0x00}}, {0x00FB, {0x75, 0x00}},
+    {0x00FC, {0x75, 0x00}}, {0x00FD, {0x79, 0x00}}, {0x00FE, {0x74, 0x68}},
+    {0x00FF, {0x79, 0x00}}, {0x0100, {0x41, 0x00}}, {0x0101, {0x61, 0x00}},
+    {0x0102, {0x41, 0x00}}, {0x0103, {0x61, 0x00}}, {0x0104, {0x41, 0x00}},
+    {0x0105, {0x61, 0x00}}, {0x0106, {0x43, 0x00}}, {0x0107, {0x63, 0x00}},
+    {0x0108, {0x43, 0x00}}, {0x0109, {0x63, 0x00}}, {0x010A, {0x43, 0x00}},
+    {0x010B, {0x63, 0x00}}, {0x010C, {0x43, 0x00}}, {0x010D, {0x63, 0x00}},
+    {0x010E, {0x44, 0x00}}, {0x010F, {0x64, 0x00}}, {0x0110, {0x44, 0x00}},
+    {0x0111, {0x64, 0x00}}, {0x0112, {0x45, 0x00}}, {0x0113, {0x65, 0x00}},
+    {0x0114, {0x45, 0x00}}, {0x0115, {0x65, 0x00}}, {0x0116, {0x45, 0x00}},
+    {0x0117, {0x65, 0x00}}, {0x0118, {0x45, 0x00}}, {0x0119, {0x65, 0x00}},
+    {0x011A, {0x45, 0x00}}, {0x011B, {0x65, 0x00}}, {0x011C, {0x47, 0x00}},
+    {0x011D, {0x67, 0x00}}, {0x011E, {0x47, 0x00}}, {0x011F, {0x67, 0x00}},
+    {0x0120, {0x47, 0x00}}, {0x0121, {0x67, 0x00}}, {0x0122, {0x47, 0x00}},
+    {0x0123, {0x67, 0x00}}, {0x0124, {0x48, 0x00}}, {0x0125, {0x68, 0x00}},
+    {0x0128, {0x49, 0x00}}, {0x0129, {0x69, 0x00}}, {0x012A, {0x49, 0x00}},
+    {0x012B, {0x69, 0x00}}, {0x012C, {0x49, 0x00}}, {0x012D, {0x69, 0x00}},
+    {0x012E, {0x49, 0x00}}, {0x012F, {0x69, 0x00}}, {0x0130, {0x49, 0x00}},
+    {0x0131, {0x69, 0x00}}, {0x0134, {0x4A, 0x00}}, {0x0135, {0x6A, 0x00}},
+    {0x0136, {0x4B, 0x00}}, {0x0137, {0x6B, 0x00}}, {0x0139, {0x4C, 0x00}},
+    {0x013A, {0x6C, 0x00}}, {0x013B, {0x4C, 0x00}}, {0x013C, {0x6C, 0x00}},
+    {0x013D, {0x4C, 0x00}}, {0x013E, {0x6C, 0x00}}, {0x0141, {0x4C, 0x00}},
+    {0x0142, {0x6C, 0x00}}, {0x0143, {0x4E, 0x00}}, {0x0144, {0x6E, 0x00}},
+    {0x0145, {0x4E, 0x00}}, {0x0146, {0x6E, 0x00}}, {0x0147, {0x4E, 0x00}},
+    {0x0148, {0x6E, 0x00}}, {0x014C, {0x4F, 0x00}}, {0x014D, {0x6F, 0x00}},
+    {0x014E, {0x4F, 0x00}}, {0x014F, {0x6F, 0x00}}, {0x0150, {0x4F, 0x00}},
+    {0x0151, {0x6F, 0x00}}, {0x0152, {0x4F, 0x45}}, {0x0153, {0x6F, 0x65}},
+    {0x0154, {0x52, 0x00}}, {0x0155, {0x72, 0x00}}, {0x0156, {0x52, 0x00}},
+    {0x0157, {0x72, 0x00}}, {0x0158, {0x52, 0x00}}, {0x0159, {0x72, 0x00}},
+    {0x015A, {0x53, 0x00}}, {0x015B, {0x73, 0x00}}, {0x015C, {0x53, 0x00}},
+    {0x015D, {0x73, 0x00}}, {0x015E, {0x53, 0x00}}, {0x015F, {0x73, 0x00}},
+    {0x0160, {0x53, 0x00}}, {0x0161, {0x73, 0x00}}, {0x0162, {0x54, 0x00}},
+    {0x0163, {0x74, 0x00}}, {0x0164, {0x54, 0x00}}, {0x0165, {0x74, 0x00}},
+    {0x0168, {0x55, 0x00}}, {0x0169, {0x75, 0x00}}, {0x016A, {0x55, 0x00}},
+    {0x016B, {0x75, 0x00}}, {0x016C, {0x55, 0x00}}, {0x016D, {0x75, 0x00}},
+    {0x016E, {0x55, 0x00}}, {0x016F, {0x75, 0x00}}, {0x0170, {0x55, 0x00}},
+    {0x0171, {0x75, 0x00}}, {0x0172, {0x55, 0x00}}, {0x0173, {0x75, 0x00}},
+    {0x0174, {0x57, 0x00}}, {0x0175, {0x77, 0x00}}, {0x0176, {0x59, 0x00}},
+    {0x0177, {0x79, 0x00}}, {0x0178, {0x59, 0x00}}, {0x0179, {0x5A, 0x00}},
+    {0x017A, {0x7A, 0x00}}, {0x017B, {0x5A, 0x00}}, {0x017C, {0x7A, 0x00}},
+    {0x017D, {0x5A, 0x00}}, {0x017E, {0x7A, 0x00}}, {0x01A0, {0x4F, 0x00}},
+    {0x01A1, {0x6F, 0x00}}, {0x01AF, {0x55, 0x00}}, {0x01B0, {0x75, 0x00}},
+    {0x01CD, {0x41, 0x00}}, {0x01CE, {0x61, 0x00}}, {0x01CF, {0x49, 0x00}},
+    {0x01D0, {0x69, 0x00}}, {0x01D1, {0x4F, 0x00}}, {0x01D2, {0x6F, 0x00}},
+    {0x01D3, {0x55, 0x00}}, {0x01D4, {0x75, 0x00}}, {0x01D5, {0x55, 0x00}},
+    {0x01D6, {0x75, 0x00}}, {0x01D7, {0x55, 0x00}}, {0x01D8, {0x75, 0x00}},
+    {0x01D9, {0x55, 0x00}}, {0x01DA, {0x75, 0x00}}, {0x01DB, {0x55, 0x00}},
+    {0x01DC, {0x75, 0x00}}, {0x01DE, {0x41, 0x00}}, {0x01DF, {0x61, 0x00}},
+    {0x01E0, {0x41, 0x00}}, {0x01E1, {0x61, 0x00}}, {0x01E6, {0x47, 0x00}},
+    {0x01E7, {0x67, 0x00}}, {0x01E8, {0x4B, 0x00}}, {0x01E9, {0x6B, 0x00}},
+    {0x01EA, {0x4F, 0x00}}, {0x01EB, {0x6F, 0x00}}, {0x01EC, {0x4F, 0x00}},
+    {0x01ED, {0x6F, 0x00}}, {0x01F0, {0x6A, 0x00}}, {0x01F4, {0x47, 0x00}},
+    {0x01F5, {0x67, 0x00}}, {0x01F8, {0x4E, 0x00}}, {0x01F9, {0x6E, 0x00}},
+    {0x01FA, {0x41, 0x00}}, {0x01FB, {0x61, 0x00}}, {0x0200, {0x41, 0x00}},
+    {0x0201, {0x61, 0x00}}, {0x0202, {0x41, 0x00}}, {0x0203, {0x61, 0x00}},
+    {0x0204, {0x45, 0x00}}, {0x0205, {0x65, 0x00}}, {0x0206, {0x45, 0x00}},
+    {0x0207, {0x65, 0x00}}, {0x0208, {0x49, 0x00}}, {0x0209, {0x69, 0x00}},
+    {0x020A, {0x49, 0x00}}, {0x020B, {0x69, 0x00}}, {0x020C, {0x4F, 0x00}},
+    {0x020D, {0x6F, 0x00}}, {0x020E, {0x4F, 0x00}}, {0x020F, {0x6F, 0x00}},
+    {0x0210, {0x52, 0x00}}, {0x0211, {0x72, 0x00}}, {0x0212, {0x52, 0x00}},
+    {0x0213, {0x72, 0x00}}, {0x0214, {0x55, 0x00}}, {0x0215, {0x75, 0x00}},
+    {0x0216, {0x55, 0x00}}, {0x0217, {0x75, 0x00}}, {0x0218, {0x53, 0x00}},
+    {0x0219, {0x73, 0x00}}, {0x021A, {0x54, 0x00}}, {0x021B, {0x74, 0x00}},
+    {0x021E, {0x48, 0x00}}, {0x021F, {0x68, 0x00}}, {0x0226, {0x41, 0x00}},
+    {0x0227, {0x61, 0x00}}, {0x0228, {0x45, 0x00}}, {0x0229, {0x65, 0x00}},
+    {0x022A, {0x4F, 0x00}}, {0x022B, {0x6F, 0x00}}, {0x022C, {0x4F, 0x00}},
+    {0x022D, {0x6F, 0x00}}, {0x022E, {0x4F, 0x00}}, {0x022F, {0x6F, 0x00}},
+    {0x0230, {0x4F, 0x00}}, {0x0231, {0x6F, 0x00}}, {0x0232, {0x59, 0x00}},
+    {0x0233, {0x79, 0x00}}, {0x03A9, {0x4F, 0x00}}, {0x03BC, {0x75, 0x00}},
+    {0x03C0, {0x70, 0x00}}, {0x2013, {0x2D, 0x00}}, {0x2014, {0x2D, 0x00}},
+    {0x2018, {0x27, 0x00}}, {0x2019, {0x27, 0x00}}, {0x201A, {0x27, 0x00}},
+    {0x201C, {0x22, 0x00}}, {0x201D, {0x22, 0x00}}, {0x201E, {0x22, 0x00}},
+    {0x2022, {0x2E, 0x00}}, {0x2026, {0x2E, 0x2E}}, {0x2032, {0x27, 0x00}},
+    {0x2033, {0x22, 0x00}}, {0x20AC, {0x45, 0x00}}, {0x2126, {0x4F, 0x00}},
+    {0x2190, {0x3C, 0x00}}, {0x2191, {0x5E, 0x00}}, {0x2192, {0x3E, 0x00}},
+    {0x2193, {0x76, 0x00}}, {0x2264, {0x3C, 0x00}}, {0x2265, {0x3E, 0x00}},
+};
+
+// END lcd_romgen.py
+
+// Big characters are drawn like seven-segment digits, 3 cells wide, from the
+// few custom characters below (stored from the slot given to lcd_big_init()).
+// Vertical segments fill whole cells, the horizontal ones are bars at the top
+// or bottom of a cell. On a 2 row font the middle bar is at the bottom of the
+// first row, on a 4 row font at the bottom of the second row.
+enum {
+  _LCD_BIG_SPACE,
+  _LCD_BIG_FULL,
+  _LCD_BIG_TOP,
+  _LCD_BIG_BOTTOM,
+  _LCD_BIG_BOTH,
+  _LCD_BIG_DOT,
+  _LCD_BIG_GLYPHS = _LCD_BIG_DOT
+};
+
+static const uint8_t _lcd_big_glyphs[_LCD_BIG_GLYPHS][8] = {
+    {0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},  // _LCD_BIG_FULL
+    {0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00},  // _LCD_BIG_TOP
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},  // _LCD_BIG_BOTTOM
+    {0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x1F, 0x1F, 0x1F},  // _LCD_BIG_BOTH
+    {0x00, 0x00, 0x0E, 0x0E, 0x0E, 0x00, 0x00, 0x00},  // _LCD_BIG_DOT
+};
+
+#define _LCD_SEG_A 0x01  // top
+#define _LCD_SEG_B 0x02  // top right
+#define _LCD_SEG_C 0x04  // bottom right
+#define _LCD_SEG_D 0x08  // bottom
+#define _LCD_SEG_E 0x10  // bottom left
+#define _LCD_SEG_F 0x20  // top left
+#define _LCD_SEG_G 0x40  // middle
+
+// Cell with the bars `top` and `bottom` if they are among the segments `s`.
+#define _LCD_BIG_BAR(s, top, bottom)                                 \
+  (((s) & (top)) ? (((s) & (bottom)) ? _LCD_BIG_BOTH : _LCD_BIG_TOP) \
+                 : (((s) & (bottom)) ? _LCD_BIG_BOTTOM : _LCD_BIG_SPACE))
+// Cell of a side column, full if the vertical segment `side` is lit.
+#define _LCD_BIG_SIDE(s, side, top, bottom) \
+  (((s) & (side)) ? _LCD_BIG_FULL : _LCD_BIG_BAR(s, top, bottom))
+
+// Cells of a 2 row character, row by row.
+#define _LCD_BIG2(s)                                                 \
+  {_LCD_BIG_SIDE(s, _LCD_SEG_F, _LCD_SEG_A, _LCD_SEG_G),             \
+   _LCD_BIG_BAR(s, _LCD_SEG_A, _LCD_SEG_G),                          \
+   _LCD_BIG_SIDE(s, _LCD_SEG_B, _LCD_SEG_A, _LCD_SEG_G),             \
+   _LCD_BIG_SIDE(s, _LCD_SEG_E, 0, _LCD_SEG_D),                      \
+   _LCD_BIG_BAR(s, 0, _LCD_SEG_D),                                   \
+   _LCD_BIG_SIDE(s, _LCD_SEG_C, 0, _LCD_SEG_D)}
+// Cells of a 4 row character, row by row.
+#define _LCD_BIG4(s)                                                 \
+  {_LCD_BIG_SIDE(s, _LCD_SEG_F, _LCD_SEG_A, 0),                      \
+   _LCD_BIG_BAR(s, _LCD_SEG_A, 0),                                   \
+   _LCD_BIG_SIDE(s, _LCD_SEG_B, _LCD_SEG_A, 0),                      \
+   _LCD_BIG_SIDE(s, _LCD_SEG_F, 0, _LCD_SEG_G),                      \
+   _LCD_BIG_BAR(s, 0, _LCD_SEG_G),                                   \
+   _LCD_BIG_SIDE(s, _LCD_SEG_B, 0, _LCD_SEG_G),                      \
+   _LCD_BIG_SIDE(s, _LCD_SEG_E, 0, 0),                               \
+   _LCD_BIG_SPACE,                                                   \
+   _LCD_BIG_SIDE(s, _LCD_SEG_C, 0, 0),                               \
+   _LCD_BIG_SIDE(s, _LCD_SEG_E, 0, _LCD_SEG_D),                      \
+   _LCD_BIG_BAR(s, 0, _LCD_SEG_D),                                   \
+   _LCD_BIG_SIDE(s, _LCD_SEG_C, 0, _LCD_SEG_D)}
+
+// Segments of the characters in _lcd_big_chars, same order.
+#define _LCD_BIG_SEGMENTS(X)                                                  \
+  X(0x3F) X(0x06) X(0x5B) X(0x4F) X(0x66) X(0x6D) X(0x7D) X(0x07) X(0x7F)     \
+  X(0x6F) X(0x00) X(0x40) X(0x63) X(0x77) X(0x7C) X(0x39) X(0x58) X(0x5E)     \
+  X(0x79) X(0x71) X(0x76) X(0x38) X(0x5C) X(0x73) X(0x50) X(0x3E)
+#define _LCD_BIG2_ENTRY(s) _LCD_BIG2(s),
+#define _LCD_BIG4_ENTRY(s) _LCD_BIG4(s),
+
+// Characters drawn with segments, '*' is the degree sign.
+static const char _lcd_big_chars[] = "0123456789 -*AbCcdEFHLoPrU";
+
+// Cells of every character in _lcd_big_chars, computed by the compiler.
+static const uint8_t _lcd_big2[][6] = {_LCD_BIG_SEGMENTS(_LCD_BIG2_ENTRY)};
+static const uint8_t _lcd_big4[][12] = {_LCD_BIG_SEGMENTS(_LCD_BIG4_ENTRY)};
+
+// Number of custom characters of the bar graphs, cells with 1 to 5 of their 5
+// pixel columns filled from the left.
+#define _LCD_BAR_GLYPHS 5
+
+// 5x7 font of the smooth scrolling ticker, ASCII 0x20-0x7E. One byte per pixel
+// column, the least significant bit is the top row.
+static const uint8_t _lcd_font[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00},  // ' '
+    {0x00, 0x00, 0x5F, 0x00, 0x00},  // '!'
+    {0x00, 0x07, 0x00, 0x07, 0x00},  // '"'
+    {0x14, 0x7F, 0x14, 0x7F, 0x14},  // '#'
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12},  // '$'
+    {0x23, 0x13, 0x08, 0x64, 0x62},  // '%'
+    {0x36, 0x49, 0x55, 0x22, 0x50},  // '&'
+    {0x00, 0x05, 0x03, 0x00, 0x00},  // '\''
+    {0x00, 0x1C, 0x22, 0x41, 0x00},  // '('
+    {0x00, 0x41, 0x22, 0x1C, 0x00},  // ')'
+    {0x08, 0x2A, 0x1C, 0x2A, 0x08},  // '*'
+    {0x08, 0x08, 0x3E, 0x08, 0x08},  // '+'
+    {0x00, 0x50, 0x30, 0x00, 0x00},  // ','
+    {0x08, 0x08, 0x08, 0x08, 0x08},  // '-'
+    {0x00, 0x60, 0x60, 0x00, 0x00},  // '.'
+    {0x20, 0x10, 0x08, 0x04, 0x02},  // '/'
+    {0x3E, 0x51, 0x49, 0x45, 0x3E},  // '0'
+    {0x00, 0x42, 0x7F, 0x40, 0x00},  // '1'
+    {0x42, 0x61, 0x51, 0x49, 0x46},  // '2'
+    {0x21, 0x41, 0x45, 0x4B, 0x31},  // '3'
+    {0x18, 0x14, 0x12, 0x7F, 0x10},  // '4'
+    {0x27, 0x45, 0x45, 0x45, 0x39},  // '5'
+    {0x3C, 0x4A, 0x49, 0x49, 0x30},  // '6'
+    {0x01, 0x71, 0x09, 0x05, 0x03},  // '7'
+    {0x36, 0x49, 0x49, 0x49, 0x36},  // '8'
+    {0x06, 0x49, 0x49, 0x29, 0x1E},  // '9'
+    {0x00, 0x36, 0x36, 0x00, 0x00},  // ':'
+    {0x00, 0x56, 0x36, 0x00, 0x00},  // ';'
+    {0x08, 0x14, 0x22, 0x41, 0x00},  // '<'
+    {0x14, 0x14, 0x14, 0x14, 0x14},  // '='
+    {0x00, 0x41, 0x22, 0x14, 0x08},  // '>'
+    {0x02, 0x01, 0x51, 0x09, 0x06},  // '?'
+    {0x32, 0x49, 0x79, 0x41, 0x3E},  // '@'
+    {0x7E, 0x11, 0x11, 0x11, 0x7E},  // 'A'
+    {0x7F, 0x49, 0x49, 0x49, 0x36},  // 'B'
+    {0x3E, 0x41, 0x41, 0x41, 0x22},  // 'C'
+    {0x7F, 0x41, 0x41, 0x22, 0x1C},  // 'D'
+    {0x7F, 0x49, 0x49, 0x49, 0x41},  // 'E'
+    {0x7F, 0x09, 0x09, 0x09, 0x01},  // 'F'
+    {0x3E, 0x41, 0x49, 0x49, 0x7A},  // 'G'
+    {0x7F, 0x08, 0x08, 0x08, 0x7F},  // 'H'
+    {0x00, 0x41, 0x7F, 0x41, 0x00},  // 'I'
+    {0x20, 0x40, 0x41, 0x3F, 0x01},  // 'J'
+    {0x7F, 0x08, 0x14, 0x22, 0x41},  // 'K'
+    {0x7F, 0x40, 0x40, 0x40, 0x40},  // 'L'
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F},  // 'M'
+    {0x7F, 0x04, 0x08, 0x10, 0x7F},  // 'N'
+    {0x3E, 0x41, 0x41, 0x41, 0x3E},  // 'O'
+    {0x7F, 0x09, 0x09, 0x09, 0x06},  // 'P'
+    {0x3E, 0x41, 0x51, 0x21, 0x5E},  // 'Q'
+    {0x7F, 0x09, 0x19, 0x29, 0x46},  // 'R'
+    {0x46, 0x49, 0x49, 0x49, 0x31},  // 'S'
+    {0x01, 0x01, 0x7F, 0x01, 0x01},  // 'T'
+    {0x3F, 0x40, 0x40, 0x40, 0x3F},  // 'U'
+    {0x1F, 0x20, 0x40, 0x20, 0x1F},  // 'V'
+    {0x3F, 0x40, 0x38, 0x40, 0x3F},  // 'W'
+    {0x63, 0x14, 0x08, 0x14, 0x63},  // 'X'
+    {0x07, 0x08, 0x70, 0x08, 0x07},  // 'Y'
+    {0x61, 0x51, 0x49, 0x45, 0x43},  // 'Z'
+    {0x00, 0x7F, 0x41, 0x41, 0x00},  // '['
+    {0x02, 0x04, 0x08, 0x10, 0x20},  // '\\'
+    {0x00, 0x41, 0x41, 0x7F, 0x00},  // ']'
+    {0x04, 0x02, 0x01, 0x02, 0x04},  // '^'
+    {0x40, 0x40, 0x40, 0x40, 0x40},  // '_'
+    {0x00, 0x01, 0x02, 0x04, 0x00},  // '`'
+    {0x20, 0x54, 0x54, 0x54, 0x78},  // 'a'
+    {0x7F, 0x48, 0x44, 0x44, 0x38},  // 'b'
+    {0x38, 0x44, 0x44, 0x44, 0x20},  // 'c'
+    {0x38, 0x44, 0x44, 0x48, 0x7F},  // 'd'
+    {0x38, 0x54, 0x54, 0x54, 0x18},  // 'e'
+    {0x08, 0x7E, 0x09, 0x01, 0x02},  // 'f'
+    {0x0C, 0x52, 0x52, 0x52, 0x3E},  // 'g'
+    {0x7F, 0x08, 0x04, 0x04, 0x78},  // 'h'
+    {0x00, 0x44, 0x7D, 0x40, 0x00},  // 'i'
+    {0x20, 0x40, 0x44, 0x3D, 0x00},  // 'j'
+    {0x7F, 0x10, 0x28, 0x44, 0x00},  // 'k'
+    {0x00, 0x41, 0x7F, 0x40, 0x00},  // 'l'
+    {0x7C, 0x04, 0x18, 0x04, 0x78},  // 'm'
+    {0x7C, 0x08, 0x04, 0x04, 0x78},  // 'n'
+    {0x38, 0x44, 0x44, 0x44, 0x38},  // 'o'
+    {0x7C, 0x14, 0x14, 0x14, 0x08},  // 'p'
+    {0x08, 0x14, 0x14, 0x18, 0x7C},  // 'q'
+    {0x7C, 0x08, 0x04, 0x04, 0x08},  // 'r'
+    {0x48, 0x54, 0x54, 0x54, 0x20},  // 's'
+    {0x04, 0x3F, 0x44, 0x40, 0x20},  // 't'
+    {0x3C, 0x40, 0x40, 0x20, 0x7C},  // 'u'
+    {0x1C, 0x20, 0x40, 0x20, 0x1C},  // 'v'
+    {0x3C, 0x40, 0x30, 0x40, 0x3C},  // 'w'
+    {0x44, 0x28, 0x10, 0x28, 0x44},  // 'x'
+    {0x0C, 0x50, 0x50, 0x50, 0x3C},  // 'y'
+    {0x44, 0x64, 0x54, 0x4C, 0x44},  // 'z'
+    {0x00, 0x08, 0x36, 0x41, 0x00},  // '{'
+    {0x00, 0x00, 0x7F, 0x00, 0x00},  // '|'
+    {0x00, 0x41, 0x36, 0x08, 0x00},  // '}'
+    {0x08, 0x04, 0x08, 0x10, 0x08},  // '~'
+};
+
 // ########################################################################## //
 //                                                                            //
 //        Private functions definition (not listed in LCD_HD44780U.h)         //
 //                                                                            //
 // ########################################################################## //
 
-LCD_Handle *_lcd_init(uint8_t cols, uint8_t rows, uint8_t charsize, uint8_t rs,
-                      uint8_t rw, uint8_t enable, uint8_t d0, uint8_t d1,
-                      uint8_t d2, uint8_t d3, uint8_t d4, uint8_t d5,
-                      uint8_t d6, uint8_t d7, bool eightbitmode);
+LCD_Handle *_lcd_init(void *storage, size_t storage_size, uint8_t cols,
+                      uint8_t rows, uint8_t charsize, uint8_t rs, uint8_t rw,
+                      uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2,
+                      uint8_t d3, uint8_t d4, uint8_t d5, uint8_t d6,
+                      uint8_t d7, bool eightbitmode);
 void _lcd_setup(LCD_Handle *handle, uint8_t cols, uint8_t rows,
                 uint8_t charsize);
+LCD_Handle *_lcd_finish_init(LCD_Handle *handle);
+uint32_t _lcd_init_step(LCD_Handle *handle);
+int64_t _lcd_init_alarm(alarm_id_t id, void *user_data);
 void _lcd_init_pins(LCD_Handle *handle);
 void _lcd_deinit_pins(LCD_Handle *handle);
 
@@ -40,13 +677,143 @@ void _lcd_send_command(LCD_Handle *handle, uint8_t command);
 void _lcd_send_data(LCD_Handle *handle, uint8_t data);
 uint8_t _lcd_read_command(LCD_Handle *handle);
 uint8_t _lcd_read_data(LCD_Handle *handle);
+void _lcd_read_ddram(LCD_Handle *handle, uint8_t *buffer);
+void _lcd_read_cgram(LCD_Handle *handle, uint8_t *buffer);
+bool _lcd_probe(LCD_Handle *handle);
+void _lcd_restore(LCD_Handle *handle, uint8_t displaymode, uint8_t address,
+                  bool cgram_selected);
+
+bool _lcd_config_matches(uint8_t rs, uint8_t rw, uint8_t enable,
+                         const uint8_t data_pins[8], bool eightbitmode);
+
+_LCD_BUS_INLINE void _lcd_write_8_bits(LCD_Handle *handle, uint8_t data);
+_LCD_BUS_INLINE void _lcd_write_4_bits(LCD_Handle *handle, uint8_t data);
+_LCD_BUS_INLINE uint8_t _lcd_read_8_bits(LCD_Handle *handle);
+_LCD_BUS_INLINE uint8_t _lcd_read_2x4_bits(LCD_Handle *handle);
+_LCD_BUS_INLINE void _lcd_put_data_pins(LCD_Handle *handle, uint8_t data,
+                                        int count);
+_LCD_BUS_INLINE uint8_t _lcd_get_data_pins(LCD_Handle *handle, int count);
+
+void _lcd_flush_frame(LCD_Handle *handle, bool attributes);
+bool _lcd_clear_by_writing(LCD_Handle *handle);
+void _lcd_sync_display_control(LCD_Handle *handle);
+void _lcd_write_number(LCD_Handle *handle, int32_t value, uint8_t decimals,
+                       uint8_t width, uint8_t flags, uint8_t col, uint8_t row);
+uint8_t _lcd_format_number(uint8_t *text, uint8_t width, int32_t value,
+                           uint8_t decimals, uint8_t flags);
+void _lcd_write_cells(LCD_Handle *handle, const uint8_t *cells, uint8_t count,
+                      uint8_t col, uint8_t row);
+void _lcd_show_cells(LCD_Handle *handle, uint8_t count, uint8_t col,
+                     uint8_t row);
+bool _lcd_blink_hidden(LCD_Handle *handle);
+uint8_t _lcd_apply_attributes(LCD_Handle *handle, size_t cell, bool hidden);
+void _lcd_put_cell(LCD_Handle *handle, size_t cell, uint8_t code,
+                   bool planned);
+int _lcd_plan_glyph(LCD_Handle *handle, uint32_t codepoint);
+void _lcd_plan_screen(LCD_Handle *handle);
+void _lcd_window_put(LCD_Window *window, uint8_t col, uint8_t row,
+                     uint8_t code, uint8_t attributes);
+void _lcd_touch_window(LCD_Window *window, uint8_t col, uint8_t row,
+                       uint8_t width, uint8_t height);
+void _lcd_touch_windows(LCD_Handle *handle);
+void _lcd_compose(LCD_Handle *handle);
+void _lcd_compose_cell(LCD_Handle *handle, uint8_t col, uint8_t row);
+uint32_t _lcd_hidden_glyphs(LCD_Handle *handle);
+void _lcd_write_big(LCD_Handle *handle, const uint8_t *text, uint8_t length,
+                    uint8_t col, uint8_t row);
+void _lcd_write_bar(LCD_Handle *handle, uint16_t value, uint16_t max,
+                    uint8_t width, uint8_t col, uint8_t row);
+void _lcd_update_sparkline(LCD_Handle *handle);
+void _lcd_canvas_set(LCD_Handle *handle, int16_t x, int16_t y, bool on);
+void _lcd_write_cgram(LCD_Handle *handle, uint8_t slots, const uint8_t *rows);
+uint8_t _lcd_sprite_cells(LCD_Handle *handle, uint8_t *cells);
+void _lcd_render_ticker(LCD_Handle *handle);
+void _lcd_start_animations(LCD_Handle *handle);
+int64_t _lcd_animation_alarm(alarm_id_t id, void *user_data);
+void _lcd_sprite_composite(LCD_Handle *handle, uint8_t cell,
+                           uint8_t background, bool planned, uint8_t *rows);
+uint8_t _lcd_encode(LCD_Handle *handle, const char **text, uint8_t codes[2]);
+uint32_t _lcd_decode(LCD_Handle *handle, const char **text);
+uint8_t _lcd_translate(LCD_Handle *handle, uint32_t codepoint,
+                       uint8_t codes[2]);
+uint8_t _lcd_lookup(LCD_Handle *handle, uint32_t codepoint, uint8_t codes[2]);
+uint8_t _lcd_lookup_rom(LCD_Handle *handle, uint32_t codepoint,
+                        uint8_t codes[2]);
+uint8_t _lcd_transliterate(uint32_t codepoint, uint8_t codes[2]);
+const _LCD_RomEntry *_lcd_find_entry(const _LCD_RomEntry *table, size_t count,
+                                     uint32_t codepoint);
+const _LCD_Glyph *_lcd_find_glyph(uint32_t codepoint);
+int _lcd_glyph_slot(LCD_Handle *handle, const _LCD_Glyph *glyph);
+bool _lcd_code_in_use(LCD_Handle *handle, uint8_t code);
+void _lcd_wait_instruction(LCD_Handle *handle, uint32_t us);
+void _lcd_record_transfer(LCD_Handle *handle, uint8_t flags, uint8_t value);
+void _lcd_record_byte(LCD_Handle *handle, uint8_t byte);
+size_t _lcd_replay_transfers(LCD_Handle *handle, const uint8_t *stream,
+                             size_t length);
+void _lcd_replay_track(LCD_Handle *handle, const uint8_t *stream,
+                       size_t length);
+uint8_t _lcd_begin_sequential(LCD_Handle *handle);
+void _lcd_end_sequential(LCD_Handle *handle, uint8_t displaymode,
+                         uint8_t address, bool cgram_selected);
+void _lcd_track_command(LCD_Handle *handle, uint8_t command);
+void _lcd_track_data(LCD_Handle *handle, uint8_t data);
+void _lcd_track_shift(LCD_Handle *handle, bool right);
+uint8_t _lcd_next_address(LCD_Handle *handle, uint8_t address, bool increment);
+int _lcd_cell_index(LCD_Handle *handle, uint8_t address);
+
+_LCD_BUS_INLINE bool _lcd_busy(LCD_Handle *handle);
+_LCD_BUS_INLINE void _lcd_wait_ready(LCD_Handle *handle);
+void _lcd_delay_us(LCD_Handle *handle, uint32_t us);
+
+#if LCD_ENABLE_STATS
+void _lcd_stats_record_api(LCD_Handle *handle, LCD_Api api, uint32_t start);
+#endif
+
+// ########################################################################## //
+//                                                                            //
+//                          Instrumentation helpers                           //
+//                                                                            //
+// ########################################################################## //
 
-void _lcd_write_8_bits(LCD_Handle *handle, uint8_t data);
-void _lcd_write_4_bits(LCD_Handle *handle, uint8_t data);
-uint8_t _lcd_read_8_bits(LCD_Handle *handle);
-uint8_t _lcd_read_4_bits(LCD_Handle *handle);
+// The counters compile to nothing unless LCD_ENABLE_STATS is set, so the
+// transfer routines can be instrumented unconditionally. API calls made by
+// other API calls are part of the outer call and aren't counted themselves.
+#if LCD_ENABLE_STATS
+#define _LCD_STATS_ADD(handle, field, value) ((handle)->_stats.field += (value))
+#define _LCD_STATS_API_BEGIN(handle) \
+  const uint32_t _lcd_api_start = ((handle)->_api_depth++, time_us_32())
+#define _LCD_STATS_API_END(handle, api) \
+  _lcd_stats_record_api((handle), (api), _lcd_api_start)
+#define _LCD_STATS_BUS_BEGIN(handle)           \
+  const uint32_t _lcd_bus_start = time_us_32(); \
+  const uint64_t _lcd_wait_start = (handle)->_stats.wait_us
+#define _LCD_STATS_BUS_END(handle)                                \
+  ((handle)->_stats.bus_us += (time_us_32() - _lcd_bus_start) -  \
+                              ((handle)->_stats.wait_us - _lcd_wait_start))
+#else
+#define _LCD_STATS_ADD(handle, field, value) ((void)0)
+#define _LCD_STATS_API_BEGIN(handle) ((void)0)
+#define _LCD_STATS_API_END(handle, api) ((void)0)
+#define _LCD_STATS_BUS_BEGIN(handle) ((void)0)
+#define _LCD_STATS_BUS_END(handle) ((void)0)
+#endif
 
-bool _lcd_busy(LCD_Handle *handle);
+// Recording a transfer is one timer read, one GPIO output register read and
+// an 8 byte store, cheap enough to leave the trace enabled in the field.
+#if LCD_ENABLE_TRACE
+#define _LCD_TRACE(handle, trace_flags, trace_value)                     \
+  do {                                                                   \
+    LCD_TraceEntry *_lcd_entry =                                         \
+        &(handle)->_trace[(handle)->_trace_count++ & (LCD_TRACE_DEPTH - 1)]; \
+    _lcd_entry->time_us = time_us_32();                                  \
+    _lcd_entry->flags =                                                  \
+        (trace_flags) |                                                  \
+        (gpio_get_out_level(_LCD_RS_PIN(handle)) ? LCD_TRACE_RS : 0);     \
+    _lcd_entry->value = (trace_value);                                   \
+  } while (0)
+#else
+#define _LCD_TRACE(handle, trace_flags, trace_value) ((void)0)
+#endif
 
 // ########################################################################## //
 //                                                                            //
@@ -80,8 +847,9 @@ LCD_Handle *lcd_init_8bit(uint8_t cols, uint8_t rows, uint8_t charsize,
                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d0,
                           uint8_t d1, uint8_t d2, uint8_t d3, uint8_t d4,
                           uint8_t d5, uint8_t d6, uint8_t d7) {
-  return _lcd_init(cols, rows, charsize, rs, rw, enable, d0, d1, d2, d3, d4, d5,
-                   d6, d7, true);
+  return _lcd_finish_init(_lcd_init(NULL, 0, cols, rows, charsize, rs, rw,
+                                    enable, d0, d1, d2, d3, d4, d5, d6, d7,
+                                    true));
 }
 
 /**
@@ -105,26 +873,364 @@ LCD_Handle *lcd_init_8bit(uint8_t cols, uint8_t rows, uint8_t charsize,
 LCD_Handle *lcd_init_4bit(uint8_t cols, uint8_t rows, uint8_t charsize,
                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d4,
                           uint8_t d5, uint8_t d6, uint8_t d7) {
-  return _lcd_init(cols, rows, charsize, rs, rw, enable, d4, d5, d6, d7, 0, 0,
-                   0, 0, false);
+  return _lcd_finish_init(_lcd_init(NULL, 0, cols, rows, charsize, rs, rw,
+                                    enable, d4, d5, d6, d7, 0, 0, 0, 0,
+                                    false));
+}
+
+/**
+ * @brief Initializes the LCD in 8-bit mode in caller-provided storage.
+ *
+ * This function works like lcd_init_8bit() but never touches the heap. The
+ * handle and its shadow buffers are placed in `storage`, which has to stay
+ * valid until lcd_deinit() and can be reused afterwards. Use LCD_STORAGE() or
+ * LCD_STORAGE_SIZE() to size it for the display.
+ *
+ * @param storage Pointer to the storage for the handle.
+ * @param storage_size Size of the storage in bytes.
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d0 GPIO pin number for data line 0.
+ * @param d1 GPIO pin number for data line 1.
+ * @param d2 GPIO pin number for data line 2.
+ * @param d3 GPIO pin number for data line 3.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @return LCD_Handle* Pointer to the initialized LCD handle (inside `storage`), or NULL if
+ *         the storage is missing or too small.
+ */
+LCD_Handle *lcd_init_8bit_static(void *storage, size_t storage_size,
+                                 uint8_t cols, uint8_t rows, uint8_t charsize,
+                                 uint8_t rs, uint8_t rw, uint8_t enable,
+                                 uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
+                                 uint8_t d4, uint8_t d5, uint8_t d6,
+                                 uint8_t d7) {
+  if (storage == NULL) {
+    return NULL;
+  }
+  return _lcd_finish_init(_lcd_init(storage, storage_size, cols, rows,
+                                    charsize, rs, rw, enable, d0, d1, d2, d3,
+                                    d4, d5, d6, d7, true));
+}
+
+/**
+ * @brief Initializes the LCD in 4-bit mode in caller-provided storage.
+ *
+ * This function works like lcd_init_4bit() but never touches the heap. The
+ * handle and its shadow buffers are placed in `storage`, which has to stay
+ * valid until lcd_deinit() and can be reused afterwards. Use LCD_STORAGE() or
+ * LCD_STORAGE_SIZE() to size it for the display.
+ *
+ * @param storage Pointer to the storage for the handle.
+ * @param storage_size Size of the storage in bytes.
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots or 5x10 dots).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @return LCD_Handle* Pointer to the initialized LCD handle (inside `storage`), or NULL if
+ *         the storage is missing or too small.
+ */
+LCD_Handle *lcd_init_4bit_static(void *storage, size_t storage_size,
+                                 uint8_t cols, uint8_t rows, uint8_t charsize,
+                                 uint8_t rs, uint8_t rw, uint8_t enable,
+                                 uint8_t d4, uint8_t d5, uint8_t d6,
+                                 uint8_t d7) {
+  if (storage == NULL) {
+    return NULL;
+  }
+  return _lcd_finish_init(_lcd_init(storage, storage_size, cols, rows,
+                                    charsize, rs, rw, enable, d4, d5, d6, d7,
+                                    0, 0, 0, 0, false));
+}
+
+/**
+ * @brief Starts the initialization of the LCD in 8-bit mode without blocking.
+ *
+ * This function works like lcd_init_8bit() but returns as soon as the pins are
+ * configured. The initialization sequence is then run by lcd_init_poll() or
+ * lcd_init_async(), so several displays can be initialized at the same time.
+ *
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d0 GPIO pin number for data line 0.
+ * @param d1 GPIO pin number for data line 1.
+ * @param d2 GPIO pin number for data line 2.
+ * @param d3 GPIO pin number for data line 3.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @return LCD_Handle* Pointer to the LCD handle, or NULL if initialization failed.
+ */
+LCD_Handle *lcd_start_8bit(uint8_t cols, uint8_t rows, uint8_t charsize,
+                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d0,
+                           uint8_t d1, uint8_t d2, uint8_t d3, uint8_t d4,
+                           uint8_t d5, uint8_t d6, uint8_t d7) {
+  return _lcd_init(NULL, 0, cols, rows, charsize, rs, rw, enable, d0, d1, d2,
+                   d3, d4, d5, d6, d7, true);
+}
+
+/**
+ * @brief Starts the initialization of the LCD in 4-bit mode without blocking.
+ *
+ * This function works like lcd_init_4bit() but returns as soon as the pins are
+ * configured. The initialization sequence is then run by lcd_init_poll() or
+ * lcd_init_async(), so several displays can be initialized at the same time.
+ *
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots or 5x10 dots).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @return LCD_Handle* Pointer to the LCD handle, or NULL if initialization failed.
+ */
+LCD_Handle *lcd_start_4bit(uint8_t cols, uint8_t rows, uint8_t charsize,
+                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d4,
+                           uint8_t d5, uint8_t d6, uint8_t d7) {
+  return _lcd_init(NULL, 0, cols, rows, charsize, rs, rw, enable, d4, d5, d6,
+                   d7, 0, 0, 0, 0, false);
+}
+
+/**
+ * @brief Starts the initialization of the LCD in 8-bit mode in caller-provided
+ *        storage without blocking.
+ *
+ * This function combines lcd_start_8bit() with the storage handling of
+ * lcd_init_8bit_static().
+ *
+ * @param storage Pointer to the storage for the handle.
+ * @param storage_size Size of the storage in bytes.
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d0 GPIO pin number for data line 0.
+ * @param d1 GPIO pin number for data line 1.
+ * @param d2 GPIO pin number for data line 2.
+ * @param d3 GPIO pin number for data line 3.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @return LCD_Handle* Pointer to the LCD handle (inside `storage`), or NULL if the
+ *         storage is missing or too small.
+ */
+LCD_Handle *lcd_start_8bit_static(void *storage, size_t storage_size,
+                                  uint8_t cols, uint8_t rows, uint8_t charsize,
+                                  uint8_t rs, uint8_t rw, uint8_t enable,
+                                  uint8_t d0, uint8_t d1, uint8_t d2,
+                                  uint8_t d3, uint8_t d4, uint8_t d5,
+                                  uint8_t d6, uint8_t d7) {
+  if (storage == NULL) {
+    return NULL;
+  }
+  return _lcd_init(storage, storage_size, cols, rows, charsize, rs, rw, enable,
+                   d0, d1, d2, d3, d4, d5, d6, d7, true);
+}
+
+/**
+ * @brief Starts the initialization of the LCD in 4-bit mode in caller-provided
+ *        storage without blocking.
+ *
+ * This function combines lcd_start_4bit() with the storage handling of
+ * lcd_init_4bit_static().
+ *
+ * @param storage Pointer to the storage for the handle.
+ * @param storage_size Size of the storage in bytes.
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots or 5x10 dots).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @return LCD_Handle* Pointer to the LCD handle (inside `storage`), or NULL if the
+ *         storage is missing or too small.
+ */
+LCD_Handle *lcd_start_4bit_static(void *storage, size_t storage_size,
+                                  uint8_t cols, uint8_t rows, uint8_t charsize,
+                                  uint8_t rs, uint8_t rw, uint8_t enable,
+                                  uint8_t d4, uint8_t d5, uint8_t d6,
+                                  uint8_t d7) {
+  if (storage == NULL) {
+    return NULL;
+  }
+  return _lcd_init(storage, storage_size, cols, rows, charsize, rs, rw, enable,
+                   d4, d5, d6, d7, 0, 0, 0, 0, false);
+}
+
+/**
+ * @brief Runs the initialization steps of the LCD that are due.
+ *
+ * This function never waits: it runs every step of the initialization sequence
+ * whose delay has passed and returns. Call it regularly (e.g. from the main loop)
+ * until it returns true. The display must not be used before that, but drawing
+ * into the frame buffer with lcd_buffer_*() is fine.
+ *
+ * @param handle Pointer to the LCD handle returned by lcd_start_*().
+ * @return true if the LCD is initialized.
+ */
+bool lcd_init_poll(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return false;
+  }
+  while (handle->_init_state != _LCD_INIT_READY &&
+         time_us_64() >= handle->_init_deadline) {
+    const uint32_t delay = _lcd_init_step(handle);
+    handle->_init_deadline = time_us_64() + delay;
+  }
+  return handle->_init_state == _LCD_INIT_READY;
+}
+
+/**
+ * @brief Runs the initialization of the LCD from a hardware alarm.
+ *
+ * This function schedules an alarm on the default alarm pool that runs the
+ * initialization steps in the background. Use lcd_is_ready() to find out when
+ * the display can be used and don't call lcd_init_poll() on the same handle.
+ *
+ * @param handle Pointer to the LCD handle returned by lcd_start_*().
+ * @return true if the alarm was started or the LCD is already initialized.
+ */
+bool lcd_init_async(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (handle->_init_state == _LCD_INIT_READY || handle->_init_alarm > 0) {
+    return true;
+  }
+  const alarm_id_t alarm =
+      add_alarm_at(from_us_since_boot(handle->_init_deadline), _lcd_init_alarm,
+                   handle, true);
+  if (alarm < 0) {
+    return false;
+  }
+  // the alarm may have finished the initialization already
+  if (handle->_init_state != _LCD_INIT_READY) {
+    handle->_init_alarm = alarm;
+  }
+  return true;
+}
+
+/**
+ * @brief Checks if the initialization of the LCD has finished.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return true if the LCD is initialized and can be used.
+ */
+bool lcd_is_ready(LCD_Handle *handle) {
+  return handle != NULL && handle->_init_state == _LCD_INIT_READY;
+}
+
+/**
+ * @brief Takes over a display that is already initialized, without clearing it.
+ *
+ * This function is meant for warm restarts (watchdog reset, bootloader handoff)
+ * where the display stayed powered. Instead of the initialization sequence it
+ * probes the controller: the address counter has to step from 0x27 to the next
+ * line in 2-line mode (or to 0x28 in 1-line mode), which only works if the
+ * controller uses the expected interface width and number of lines. A shifted
+ * display is returned home, then the shadow copies of DDRAM and CGRAM are read
+ * back from the display, which keeps showing its content. If the probe
+ * fails, initialize the display normally with lcd_init_poll() or
+ * lcd_init_async(). Requires the RW pin.
+ *
+ * @param handle Pointer to the LCD handle returned by lcd_start_*(), before
+ *               lcd_init_poll() or lcd_init_async() was called.
+ * @return true if the display was taken over and is ready.
+ */
+bool lcd_attach(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (handle->_init_state == _LCD_INIT_READY) {
+    return true;
+  }
+  if (!_LCD_HAS_RW(handle) || handle->_init_state != _LCD_INIT_FUNCTIONSET_1 ||
+      handle->_init_alarm > 0) {
+    return false;
+  }
+
+  // the entry mode is unknown, reads must increment the address counter
+  const uint8_t displaymode = _lcd_begin_sequential(handle);
+  if (!_lcd_probe(handle)) {
+    handle->_displaymode = displaymode;
+    return false;
+  }
+
+  // the probe can't see the font, so set it together with the display control
+  _lcd_send_command(handle, LCD_FUNCTIONSET | handle->_displayfunction);
+  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  // the display may have been shifted, which the shadow can't describe; the
+  // reads below poll the busy flag until the instruction has finished
+  _lcd_send_command(handle, LCD_RETURNHOME);
+  _lcd_read_ddram(handle, handle->_shadow);
+  _lcd_read_cgram(handle, handle->_cgram);
+  handle->_cgram_valid = 0xFF;
+  // the hidden part of the DDRAM is unknown
+  handle->_offscreen_dirty = true;
+  for (size_t i = 0; i < (size_t)handle->_cols * handle->_numlines; i++) {
+    _lcd_put_cell(handle, i, handle->_shadow[i], false);
+  }
+  _lcd_end_sequential(handle, displaymode, 0, false);
+
+  handle->_init_state = _LCD_INIT_READY;
+  return true;
 }
 
 /**
  * @brief Deinitializes the LCD and frees the associated resources.
  *
  * This function clears the display, returns the cursor to home position, turns off the display,
- * deinitializes the GPIO pins, and frees the memory allocated for the LCD handle.
+ * deinitializes the GPIO pins, and frees the memory allocated for the LCD handle. Storage passed
+ * to lcd_init_*_static() is not freed and can be reused by the caller.
  *
  * @param handle Pointer to the LCD handle to be deinitialized.
  * @return LCD_Handle* NULL (always returns NULL as the handle is freed).
  */
 LCD_Handle *lcd_deinit(LCD_Handle *handle) {
   if (handle != NULL) {
+    if (handle->_init_alarm > 0) {
+      cancel_alarm(handle->_init_alarm);
+    }
+    if (handle->_animation_alarm > 0) {
+      cancel_alarm(handle->_animation_alarm);
+      handle->_animation_alarm = 0;
+    }
+    handle->_transaction_depth = 0;
     lcd_clear(handle);
     lcd_home(handle);
     lcd_display_off(handle);
     _lcd_deinit_pins(handle);
-    free(handle);
+    if (!handle->_static) {
+      free(handle);
+    }
   }
   return NULL;
 }
@@ -132,8 +1238,11 @@ LCD_Handle *lcd_deinit(LCD_Handle *handle) {
 /**
  * @brief Clears the LCD display.
  *
- * This function sends a command to clear the display and waits for a short period to ensure
- * that the command is processed.
+ * This function blanks the display, removes all cell attributes and moves the
+ * cursor to the home position. If only a few characters are shown, overwriting them
+ * with spaces is quicker than the clear instruction and its long execution time, and
+ * doesn't flash the whole screen, so the cheaper way is chosen from the shadow copy.
+ * Either way the entry mode is kept.
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -141,8 +1250,25 @@ void lcd_clear(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
-  _lcd_send_command(handle, LCD_CLEARDISPLAY);
-  sleep_ms(5);  // Wait for the display to clear.
+  _LCD_STATS_API_BEGIN(handle);
+  memset(handle->_frame, ' ', (size_t)handle->_cols * handle->_numlines);
+  memset(handle->_attributes, 0, (size_t)handle->_cols * handle->_numlines);
+  handle->_attribute_cells = 0;
+  _lcd_touch_windows(handle);
+  if (_lcd_clear_by_writing(handle)) {
+    _lcd_flush_frame(handle, true);
+    if (handle->_cgram_selected || handle->_address != 0) {
+      _lcd_send_command(handle, LCD_SETDDRAMADDR);
+    }
+  } else {
+    // clearing sets the entry mode to increment, the one that was set is sent
+    // again before the next character
+    handle->_bus_depth++;
+    _lcd_send_command(handle, LCD_CLEARDISPLAY);
+    _lcd_wait_instruction(handle, _LCD_CLEAR_US);  // Wait for the clear.
+    handle->_bus_depth--;
+  }
+  _LCD_STATS_API_END(handle, LCD_API_CLEAR);
 }
 
 /**
@@ -157,14 +1283,19 @@ void lcd_home(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
+  handle->_bus_depth++;
   _lcd_send_command(handle, LCD_RETURNHOME);
-  sleep_ms(5);  // Wait for the cursor to return home.
+  _lcd_wait_instruction(handle, 5000);  // Wait for the cursor to return.
+  handle->_bus_depth--;
+  _LCD_STATS_API_END(handle, LCD_API_HOME);
 }
 
 /**
  * @brief Turns off the LCD display.
  *
- * This function sends a command to turn off the display.
+ * This function sends a command to turn off the display, unless it is already off
+ * or a transaction is open (see lcd_begin()).
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -172,14 +1303,17 @@ void lcd_display_off(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaycontrol &= ~LCD_DISPLAYON;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  _lcd_sync_display_control(handle);
+  _LCD_STATS_API_END(handle, LCD_API_DISPLAY_OFF);
 }
 
 /**
  * @brief Turns on the LCD display.
  *
- * This function sends a command to turn on the display.
+ * This function sends a command to turn on the display, unless it is already on
+ * or a transaction is open (see lcd_begin()).
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -187,14 +1321,17 @@ void lcd_display_on(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaycontrol |= LCD_DISPLAYON;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  _lcd_sync_display_control(handle);
+  _LCD_STATS_API_END(handle, LCD_API_DISPLAY_ON);
 }
 
 /**
  * @brief Turns off the cursor blinking.
  *
- * This function sends a command to disable the cursor blinking.
+ * This function sends a command to disable the cursor blinking, unless it is
+ * already disabled or a transaction is open (see lcd_begin()).
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -202,14 +1339,17 @@ void lcd_blink_off(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaycontrol &= ~LCD_BLINKON;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  _lcd_sync_display_control(handle);
+  _LCD_STATS_API_END(handle, LCD_API_BLINK_OFF);
 }
 
 /**
  * @brief Turns on the cursor blinking.
  *
- * This function sends a command to enable the cursor blinking.
+ * This function sends a command to enable the cursor blinking, unless it is
+ * already enabled or a transaction is open (see lcd_begin()).
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -217,14 +1357,17 @@ void lcd_blink_on(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaycontrol |= LCD_BLINKON;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  _lcd_sync_display_control(handle);
+  _LCD_STATS_API_END(handle, LCD_API_BLINK_ON);
 }
 
 /**
  * @brief Turns off the cursor.
  *
- * This function sends a command to hide the cursor.
+ * This function sends a command to hide the cursor, unless it is already hidden
+ * or a transaction is open (see lcd_begin()).
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -232,14 +1375,17 @@ void lcd_cursor_off(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaycontrol &= ~LCD_CURSORON;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  _lcd_sync_display_control(handle);
+  _LCD_STATS_API_END(handle, LCD_API_CURSOR_OFF);
 }
 
 /**
  * @brief Turns on the cursor.
  *
- * This function sends a command to show the cursor.
+ * This function sends a command to show the cursor, unless it is already shown
+ * or a transaction is open (see lcd_begin()).
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -247,8 +1393,10 @@ void lcd_cursor_on(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaycontrol |= LCD_CURSORON;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+  _lcd_sync_display_control(handle);
+  _LCD_STATS_API_END(handle, LCD_API_CURSOR_ON);
 }
 
 /**
@@ -262,7 +1410,9 @@ void lcd_scroll_display_left(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   _lcd_send_command(handle, LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
+  _LCD_STATS_API_END(handle, LCD_API_SCROLL_DISPLAY_LEFT);
 }
 
 /**
@@ -276,13 +1426,16 @@ void lcd_scroll_display_right(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   _lcd_send_command(handle, LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
+  _LCD_STATS_API_END(handle, LCD_API_SCROLL_DISPLAY_RIGHT);
 }
 
 /**
  * @brief Sets the text direction to left-to-right.
  *
- * This function configures the display to write text from left to right.
+ * This function configures the display to write text from left to right. The entry
+ * mode only affects data writes, so it is sent together with the next character.
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -290,14 +1443,16 @@ void lcd_left_to_right(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaymode |= LCD_ENTRYLEFT;
-  _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  _LCD_STATS_API_END(handle, LCD_API_LEFT_TO_RIGHT);
 }
 
 /**
  * @brief Sets the text direction to right-to-left.
  *
- * This function configures the display to write text from right to left.
+ * This function configures the display to write text from right to left. The entry
+ * mode only affects data writes, so it is sent together with the next character.
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -305,14 +1460,16 @@ void lcd_right_to_left(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaymode &= ~LCD_ENTRYLEFT;
-  _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  _LCD_STATS_API_END(handle, LCD_API_RIGHT_TO_LEFT);
 }
 
 /**
  * @brief Disables auto-scrolling.
  *
- * This function sends a command to disable auto-scrolling, meaning the text will not automatically scroll.
+ * This function disables auto-scrolling, meaning the text will not automatically scroll.
+ * The entry mode is sent together with the next character.
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -320,14 +1477,16 @@ void lcd_autoscroll_off(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
-  _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  _LCD_STATS_API_END(handle, LCD_API_AUTOSCROLL_OFF);
 }
 
 /**
  * @brief Enables auto-scrolling.
  *
- * This function sends a command to enable auto-scrolling, meaning the text will automatically scroll.
+ * This function enables auto-scrolling, meaning the text will automatically scroll.
+ * The entry mode is sent together with the next character.
  *
  * @param handle Pointer to the LCD handle.
  */
@@ -335,8 +1494,52 @@ void lcd_autoscroll_on(LCD_Handle *handle) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   handle->_displaymode |= LCD_ENTRYSHIFTINCREMENT;
-  _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  _LCD_STATS_API_END(handle, LCD_API_AUTOSCROLL_ON);
+}
+
+/**
+ * @brief Starts a transaction of display control changes.
+ *
+ * Until the matching lcd_commit(), lcd_display_on/off(), lcd_cursor_on/off() and
+ * lcd_blink_on/off() only update the settings, so any number of them costs at most
+ * one instruction. Transactions can be nested.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_begin(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  if (handle->_transaction_depth < UINT8_MAX) {
+    handle->_transaction_depth++;
+  }
+}
+
+/**
+ * @brief Ends a transaction started with lcd_begin().
+ *
+ * When the outermost transaction ends, the display control and entry mode settings
+ * that differ from what the controller holds are sent, one instruction each.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_commit(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  if (handle->_transaction_depth > 0) {
+    handle->_transaction_depth--;
+  }
+  _lcd_sync_display_control(handle);
+  if (handle->_transaction_depth == 0 &&
+      handle->_init_state == _LCD_INIT_READY &&
+      handle->_sent_displaymode != handle->_displaymode) {
+    _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  }
+  _LCD_STATS_API_END(handle, LCD_API_COMMIT);
 }
 
 /**
@@ -352,6 +1555,7 @@ void lcd_set_cursor(LCD_Handle *handle, uint8_t col, uint8_t row) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   const size_t max_lines =
       sizeof(handle->_row_offsets) / sizeof(*handle->_row_offsets);
   if (row >= max_lines) {
@@ -362,6 +1566,7 @@ void lcd_set_cursor(LCD_Handle *handle, uint8_t col, uint8_t row) {
   }
   _lcd_send_command(handle,
                     LCD_SETDDRAMADDR | (col + handle->_row_offsets[row]));
+  _LCD_STATS_API_END(handle, LCD_API_SET_CURSOR);
 }
 
 /**
@@ -376,13 +1581,16 @@ void lcd_write_char(LCD_Handle *handle, char symbol) {
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   _lcd_send_data(handle, symbol);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_CHAR);
 }
 
 /**
  * @brief Writes a string to the LCD.
  *
  * This function sends a string of characters to the LCD for display starting from the current cursor position.
+ * The text is translated to the character ROM as set with lcd_set_charset().
  *
  * @param handle Pointer to the LCD handle.
  * @param text Null-terminated string to be displayed.
@@ -391,9 +1599,16 @@ void lcd_write_string(LCD_Handle *handle, char *text) {
   if (handle == NULL) {
     return;
   }
-  for (size_t i = 0; i < strlen(text); i++) {
-    lcd_write_char(handle, text[i]);
+  _LCD_STATS_API_BEGIN(handle);
+  const char *next = text;
+  uint8_t codes[2];
+  while (*next != '\0') {
+    const uint8_t count = _lcd_encode(handle, &next, codes);
+    for (uint8_t i = 0; i < count; i++) {
+      lcd_write_char(handle, codes[i]);
+    }
   }
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_STRING);
 }
 
 /**
@@ -412,8 +1627,10 @@ void lcd_write_char_at(LCD_Handle *handle, char symbol, uint8_t col,
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   lcd_set_cursor(handle, col, row);
   lcd_write_char(handle, symbol);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_CHAR_AT);
 }
 
 /**
@@ -432,289 +1649,3872 @@ void lcd_write_string_at(LCD_Handle *handle, char *text, uint8_t col,
   if (handle == NULL) {
     return;
   }
+  _LCD_STATS_API_BEGIN(handle);
   lcd_set_cursor(handle, col, row);
   lcd_write_string(handle, text);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_STRING_AT);
 }
 
 /**
- * @brief Creates a custom character on the LCD.
+ * @brief Selects how text is translated to character codes.
  *
- * This function defines a new custom character pattern in the LCD's CGRAM (Character Generator RAM).
- * The pattern is specified by the `data` array and can be used later to display the custom character.
+ * With LCD_CHARSET_A00 or LCD_CHARSET_A02, lcd_write_string(), lcd_write_string_at()
+ * and lcd_buffer_string_at() take UTF-8 text and translate every character to the
+ * matching code of that character ROM. Characters the ROM lacks are drawn into a
+ * free CGRAM slot if a bitmap is known, otherwise replaced by similar ASCII
+ * characters or '?'. Custom characters created with lcd_create_char() are never
+ * overwritten. LCD_CHARSET_RAW (the default) sends the bytes unchanged.
  *
  * @param handle Pointer to the LCD handle.
- * @param num Character code for the custom character (0-7 for most LCDs).
- * @param data Array of 8 bytes representing the custom character pattern. Each byte corresponds
- *             to one row of the character (8 rows in total).
+ * @param charset LCD_CHARSET_RAW, LCD_CHARSET_A00 or LCD_CHARSET_A02.
  */
-void lcd_create_char(LCD_Handle *handle, uint8_t num, uint8_t *data) {
+void lcd_set_charset(LCD_Handle *handle, uint8_t charset) {
   if (handle == NULL) {
     return;
   }
-  uint8_t ddram_address = 0;
-  if (handle->_rw_pin != 255) {
-    ddram_address = _lcd_read_command(handle) & 0x7F;
-  }
-  uint8_t gcram_address = (num & 0x7) << 3;
+  handle->_charset = charset;
+}
+
+/**
+ * @brief Writes an integer into a fixed-width field.
+ *
+ * This function formats the number without printf and only sends the characters
+ * of the field that differ from what the display shows, so a counter going from
+ * 1234 to 1235 costs a single data byte. The cursor position is kept.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value Number to display.
+ * @param width Field width in characters (clipped at the end of the row).
+ * @param flags Combination of LCD_NUM_LEFT, LCD_NUM_ZEROS and LCD_NUM_PLUS.
+ * @param col Column of the first character of the field (0-based index).
+ * @param row Row position (0-based index).
+ */
+void lcd_write_int_at(LCD_Handle *handle, int32_t value, uint8_t width,
+                      uint8_t flags, uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  _lcd_write_number(handle, value, 0, width, flags, col, row);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_INT_AT);
+}
+
+/**
+ * @brief Writes a fixed-point number into a fixed-width field.
+ *
+ * Same as lcd_write_int_at(), but `value` counts units of 10^-decimals, e.g. 2153
+ * with 2 decimals is shown as 21.53 and -5 as -0.05.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value Number to display, scaled by 10^decimals.
+ * @param decimals Number of digits after the decimal point (0-9).
+ * @param width Field width in characters (clipped at the end of the row).
+ * @param flags Combination of LCD_NUM_LEFT, LCD_NUM_ZEROS and LCD_NUM_PLUS.
+ * @param col Column of the first character of the field (0-based index).
+ * @param row Row position (0-based index).
+ */
+void lcd_write_fixed_at(LCD_Handle *handle, int32_t value, uint8_t decimals,
+                        uint8_t width, uint8_t flags, uint8_t col,
+                        uint8_t row) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  _lcd_write_number(handle, value, decimals > 9 ? 9 : decimals, width, flags,
+                    col, row);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_FIXED_AT);
+}
+
+/**
+ * @brief Prepares the custom characters of the big font.
+ *
+ * This function uploads the 5 custom characters the big characters are made of
+ * into `first_slot` to `first_slot` + 4 with lcd_create_char(), unless they are
+ * there already. It has to be called once before lcd_write_big_at() and
+ * lcd_write_big_number_at(); the slots stay reserved for the big font.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param height Height of the characters in rows, 2 or 4.
+ * @param first_slot First custom character used (0-3).
+ * @return true if the font is ready, false if the display has fewer rows than
+ *         `height`, the height is unsupported or the slots don't fit.
+ */
+bool lcd_big_init(LCD_Handle *handle, uint8_t height, uint8_t first_slot) {
+  if (handle == NULL) {
+    return false;
+  }
+  if ((height != 2 && height != 4) || height > handle->_numlines ||
+      first_slot > 8 - _LCD_BIG_GLYPHS) {
+    return false;
+  }
+  for (uint8_t i = 0; i < _LCD_BIG_GLYPHS; i++) {
+    const uint8_t slot = first_slot + i;
+    if (!(handle->_cgram_valid & (1 << slot)) ||
+        memcmp(handle->_cgram + (slot << 3), _lcd_big_glyphs[i], 8) != 0) {
+      lcd_create_char(handle, slot, (uint8_t *)_lcd_big_glyphs[i]);
+    }
+    handle->_glyph_reserved |= 1 << slot;
+  }
+  handle->_big_height = height;
+  handle->_big_slot = first_slot;
+  return true;
+}
+
+/**
+ * @brief Writes text in big characters.
+ *
+ * Digits, space, '-', '.', ':', '*' (degree sign) and the letters of
+ * "AbCcdEFHLoPrU" are drawn 3 cells wide with one blank column after them
+ * ('.' and ':' take one cell), other characters are left blank. Only the cells
+ * that differ from the display are sent, so updating a number usually rewrites
+ * a few cells of the digits that changed. Text reaching past the last column is
+ * cut off.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param text Null-terminated string to display.
+ * @param col Column of the top left corner (0-based index).
+ * @param row Row of the top left corner (0-based index).
+ */
+void lcd_write_big_at(LCD_Handle *handle, const char *text, uint8_t col,
+                      uint8_t row) {
+  if (handle == NULL || text == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const size_t length = strlen(text);
+  _lcd_write_big(handle, (const uint8_t *)text, length > 40 ? 40 : length,
+                 col, row);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_BIG_AT);
+}
+
+/**
+ * @brief Writes a number in big characters into a fixed-width field.
+ *
+ * The number is formatted like lcd_write_fixed_at() does (`decimals` 0 for an
+ * integer) and drawn like lcd_write_big_at(), `width` counts big characters.
+ * Numbers that don't fit fill the field with dashes.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value Number to display, scaled by 10^decimals.
+ * @param decimals Number of digits after the decimal point (0-9).
+ * @param width Field width in big characters (the decimal point counts as one).
+ * @param flags Combination of LCD_NUM_LEFT, LCD_NUM_ZEROS and LCD_NUM_PLUS.
+ * @param col Column of the top left corner (0-based index).
+ * @param row Row of the top left corner (0-based index).
+ */
+void lcd_write_big_number_at(LCD_Handle *handle, int32_t value,
+                             uint8_t decimals, uint8_t width, uint8_t flags,
+                             uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  uint8_t text[10];
+  if (width > sizeof(text)) {
+    width = sizeof(text);
+  }
+  // '+' has no big character, it is shown as a blank
+  if (_lcd_format_number(text, width, value, decimals > 9 ? 9 : decimals,
+                         flags) == 0) {
+    // nor has '#', numbers that don't fit are shown as dashes
+    memset(text, '-', width);
+  }
+  _lcd_write_big(handle, text, width, col, row);
+  _LCD_STATS_API_END(handle, LCD_API_WRITE_BIG_NUMBER_AT);
+}
+
+/**
+ * @brief Prepares the custom characters of the bar graphs.
+ *
+ * This function uploads 5 custom characters with 1 to 5 pixel columns filled
+ * into `first_slot` to `first_slot` + 4, unless they are there already. All bars
+ * share them; the slots stay reserved.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param first_slot First custom character used (0-3).
+ * @return true if the bars can be drawn, false if the slots don't fit.
+ */
+bool lcd_bar_init(LCD_Handle *handle, uint8_t first_slot) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (first_slot > 8 - _LCD_BAR_GLYPHS) {
+    return false;
+  }
+  for (uint8_t i = 0; i < _LCD_BAR_GLYPHS; i++) {
+    const uint8_t slot = first_slot + i;
+    uint8_t rows[8];
+    memset(rows, (0x1F << (4 - i)) & 0x1F, sizeof(rows));
+    if (!(handle->_cgram_valid & (1 << slot)) ||
+        memcmp(handle->_cgram + (slot << 3), rows, 8) != 0) {
+      lcd_create_char(handle, slot, rows);
+    }
+    handle->_glyph_reserved |= 1 << slot;
+  }
+  handle->_bar_slot = first_slot;
+  handle->_bar_ready = true;
+  return true;
+}
+
+/**
+ * @brief Draws a horizontal bar graph.
+ *
+ * The bar fills `value` / `max` of `width` cells with a resolution of 5 steps
+ * per cell. Only the cells that differ from the display are sent, so a new
+ * value usually rewrites the one or two cells at the end of the bar.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value Current value, values above `max` fill the whole bar.
+ * @param max Value of a full bar.
+ * @param width Length of the bar in cells (clipped at the end of the row).
+ * @param col Column of the left end of the bar (0-based index).
+ * @param row Row position (0-based index).
+ */
+void lcd_bar_at(LCD_Handle *handle, uint16_t value, uint16_t max,
+                uint8_t width, uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  _lcd_write_bar(handle, value, max, width, col, row);
+  _LCD_STATS_API_END(handle, LCD_API_BAR_AT);
+}
+
+/**
+ * @brief Draws a progress bar followed by the percentage.
+ *
+ * The last 4 of the `width` cells show the percentage right-aligned, e.g.
+ * " 42%", the cells in front of it a bar like lcd_bar_at().
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param percent Progress, values above 100 are shown as 100.
+ * @param width Width of the widget in cells including the percentage, at
+ *              least 5. Nothing is drawn if the widget doesn't fit the row.
+ * @param col Column of the left end of the widget (0-based index).
+ * @param row Row position (0-based index).
+ */
+void lcd_progress_at(LCD_Handle *handle, uint8_t percent, uint8_t width,
+                     uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  if (percent > 100) {
+    percent = 100;
+  }
+  if (width > 4 && col + width <= handle->_cols &&
+      row < handle->_numlines) {
+    _lcd_write_bar(handle, percent, 100, width - 4, col, row);
+    _lcd_write_number(handle, percent, 0, 3, 0, col + width - 4, row);
+    _lcd_write_cells(handle, (const uint8_t *)"%", 1, col + width - 1, row);
+  }
+  _LCD_STATS_API_END(handle, LCD_API_PROGRESS_AT);
+}
+
+/**
+ * @brief Places a sparkline on the display.
+ *
+ * The sparkline shows the last 5 * `cells` samples as columns of 0 to 8 pixels.
+ * Every cell is a custom character, so new samples only change CGRAM, the
+ * characters on the display stay the same. The custom characters are reserved
+ * for the sparkline, a handle has at most one.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cells Width of the sparkline in cells (1-8).
+ * @param first_slot First custom character used.
+ * @param col Column of the left end of the sparkline (0-based index).
+ * @param row Row position (0-based index).
+ * @return true if the sparkline was placed, false if it doesn't fit the custom
+ *         characters or the row.
+ */
+bool lcd_sparkline_init(LCD_Handle *handle, uint8_t cells, uint8_t first_slot,
+                        uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (cells == 0 || first_slot + cells > 8 || row >= handle->_numlines ||
+      col + cells > handle->_cols) {
+    return false;
+  }
+  handle->_sparkline_cells = cells;
+  handle->_sparkline_slot = first_slot;
+  memset(handle->_sparkline_levels, 0, sizeof(handle->_sparkline_levels));
+  uint8_t codes[8];
+  for (uint8_t i = 0; i < cells; i++) {
+    codes[i] = first_slot + i;
+    handle->_glyph_reserved |= 1 << codes[i];
+    handle->_glyph_codepoints[codes[i]] = 0;
+  }
+  _lcd_update_sparkline(handle);
+  _lcd_write_cells(handle, codes, cells, col, row);
+  return true;
+}
+
+/**
+ * @brief Adds a sample to the sparkline.
+ *
+ * The older samples move one pixel column to the left. Only the CGRAM rows that
+ * change are sent, runs of them with a single address command.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value New sample, values above `max` are shown as `max`.
+ * @param max Value of a full column.
+ */
+void lcd_sparkline_push(LCD_Handle *handle, uint16_t value, uint16_t max) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t samples = handle->_sparkline_cells * 5;
+  if (samples > 0) {
+    if (value > max) {
+      value = max;
+    }
+    memmove(handle->_sparkline_levels, handle->_sparkline_levels + 1,
+            samples - 1);
+    handle->_sparkline_levels[samples - 1] =
+        max == 0 ? 0 : (uint32_t)value * 8 / max;
+    _lcd_update_sparkline(handle);
+  }
+  _LCD_STATS_API_END(handle, LCD_API_SPARKLINE_PUSH);
+}
+
+/**
+ * @brief Places a pixel canvas on the display.
+ *
+ * The canvas is `cols` x `rows` cells of 5x8 pixels drawn with the custom
+ * characters `first_slot` to 7. Blank cells are shown as spaces and identical
+ * cells share a custom character, so the canvas can be larger than the number
+ * of custom characters as long as the drawing is sparse. The canvas starts
+ * blank; drawing only changes memory until lcd_canvas_flush().
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cols Width of the canvas in cells.
+ * @param rows Height of the canvas in cells.
+ * @param first_slot First custom character used (0-7).
+ * @param col Column of the top left corner (0-based index).
+ * @param row Row of the top left corner (0-based index).
+ * @return true if the canvas was placed, false if it has more than
+ *         LCD_CANVAS_MAX_CELLS cells or doesn't fit the display.
+ */
+bool lcd_canvas_init(LCD_Handle *handle, uint8_t cols, uint8_t rows,
+                     uint8_t first_slot, uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (cols == 0 || rows == 0 || cols * rows > LCD_CANVAS_MAX_CELLS ||
+      first_slot > 7 || col + cols > handle->_cols ||
+      row + rows > handle->_numlines) {
+    return false;
+  }
+  handle->_canvas_cols = cols;
+  handle->_canvas_rows = rows;
+  handle->_canvas_col = col;
+  handle->_canvas_row = row;
+  handle->_canvas_slot = first_slot;
+  for (uint8_t slot = first_slot; slot < 8; slot++) {
+    handle->_glyph_reserved |= 1 << slot;
+    handle->_glyph_codepoints[slot] = 0;
+  }
+  lcd_canvas_clear(handle);
+  return true;
+}
+
+/**
+ * @brief Clears all pixels of the canvas.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_canvas_clear(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  memset(handle->_canvas_pixels, 0, sizeof(handle->_canvas_pixels));
+  memset(handle->_canvas_dirty, 0xFF, sizeof(handle->_canvas_dirty));
+}
+
+/**
+ * @brief Sets or clears a pixel of the canvas.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param x Pixel column, 0 is the left edge of the canvas.
+ * @param y Pixel row, 0 is the top edge of the canvas.
+ * @param on true to light the pixel, false to clear it.
+ */
+void lcd_canvas_pixel(LCD_Handle *handle, int16_t x, int16_t y, bool on) {
+  if (handle == NULL) {
+    return;
+  }
+  _lcd_canvas_set(handle, x, y, on);
+}
+
+/**
+ * @brief Draws a line on the canvas.
+ *
+ * Parts of the line outside of the canvas are left out.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param x0 Pixel column of the start.
+ * @param y0 Pixel row of the start.
+ * @param x1 Pixel column of the end.
+ * @param y1 Pixel row of the end.
+ * @param on true to light the pixels, false to clear them.
+ */
+void lcd_canvas_line(LCD_Handle *handle, int16_t x0, int16_t y0, int16_t x1,
+                     int16_t y1, bool on) {
+  if (handle == NULL) {
+    return;
+  }
+  // Bresenham's algorithm
+  const int16_t dx = x1 > x0 ? x1 - x0 : x0 - x1;
+  const int16_t dy = y1 > y0 ? y0 - y1 : y1 - y0;
+  const int16_t step_x = x0 < x1 ? 1 : -1;
+  const int16_t step_y = y0 < y1 ? 1 : -1;
+  int16_t error = dx + dy;
+  while (true) {
+    _lcd_canvas_set(handle, x0, y0, on);
+    if (x0 == x1 && y0 == y1) {
+      break;
+    }
+    const int16_t error2 = 2 * error;
+    if (error2 >= dy) {
+      error += dy;
+      x0 += step_x;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      y0 += step_y;
+    }
+  }
+}
+
+/**
+ * @brief Draws a rectangle on the canvas.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param x Pixel column of the left edge.
+ * @param y Pixel row of the top edge.
+ * @param width Width in pixels.
+ * @param height Height in pixels.
+ * @param filled true to fill the rectangle, false to draw the outline only.
+ * @param on true to light the pixels, false to clear them.
+ */
+void lcd_canvas_rect(LCD_Handle *handle, int16_t x, int16_t y, uint8_t width,
+                     uint8_t height, bool filled, bool on) {
+  if (handle == NULL) {
+    return;
+  }
+  for (int16_t j = 0; j < height; j++) {
+    for (int16_t i = 0; i < width; i++) {
+      if (filled || j == 0 || j == height - 1 || i == 0 || i == width - 1) {
+        _lcd_canvas_set(handle, x + i, y + j, on);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Copies a bitmap onto the canvas.
+ *
+ * The bitmap has one bit per pixel, every row starts with a new byte and the
+ * most significant bit is the leftmost pixel. Lit and dark pixels are both
+ * copied.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param x Pixel column of the left edge.
+ * @param y Pixel row of the top edge.
+ * @param width Width of the bitmap in pixels.
+ * @param height Height of the bitmap in pixels.
+ * @param bitmap Pixels, (width + 7) / 8 bytes per row.
+ */
+void lcd_canvas_blit(LCD_Handle *handle, int16_t x, int16_t y, uint8_t width,
+                     uint8_t height, const uint8_t *bitmap) {
+  if (handle == NULL || bitmap == NULL) {
+    return;
+  }
+  const uint8_t stride = (width + 7) >> 3;
+  for (int16_t j = 0; j < height; j++) {
+    const uint8_t *line = bitmap + j * stride;
+    for (int16_t i = 0; i < width; i++) {
+      _lcd_canvas_set(handle, x + i, y + j,
+                      (line[i >> 3] & (0x80 >> (i & 0x7))) != 0);
+    }
+  }
+}
+
+/**
+ * @brief Shows the canvas on the display.
+ *
+ * Identical cells get the same custom character and blank cells a space. A
+ * cell keeps the custom character it had if possible, so only the pixel rows
+ * that changed since the last flush are uploaded; the characters on the
+ * display are rewritten only where the assignment changed.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return true if the canvas was shown, false if it has more different cells
+ *         than custom characters (the cells without one are left blank).
+ */
+bool lcd_canvas_flush(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (handle->_init_state != _LCD_INIT_READY) {
+    return false;
+  }
+  const uint8_t cells = handle->_canvas_cols * handle->_canvas_rows;
+  bool dirty = false;
+  for (uint8_t i = 0; i < cells; i++) {
+    dirty |= handle->_canvas_dirty[i] != 0;
+  }
+  if (!dirty) {
+    return true;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t first = handle->_canvas_slot;
+  uint8_t codes[LCD_CANVAS_MAX_CELLS];
+  uint8_t rows[64];
+  // custom characters taken in this flush, and the cell they show
+  uint8_t taken = 0;
+  uint8_t owner[8];
+  bool complete = true;
+  for (uint8_t i = 0; i < cells; i++) {
+    const uint8_t *tile = handle->_canvas_pixels[i];
+    uint8_t lit = 0;
+    for (uint8_t row = 0; row < 8; row++) {
+      lit |= tile[row];
+    }
+    // 0xFF until a custom character is found
+    codes[i] = lit == 0 ? ' ' : 0xFF;
+    // an identical cell or a custom character holding the tile already
+    for (uint8_t slot = first; slot < 8 && codes[i] == 0xFF; slot++) {
+      const uint8_t bit = 1 << slot;
+      if ((taken & bit)
+              ? memcmp(handle->_canvas_pixels[owner[slot]], tile, 8) == 0
+              : (handle->_cgram_valid & bit) &&
+                    memcmp(handle->_cgram + (slot << 3), tile, 8) == 0) {
+        codes[i] = slot;
+        taken |= bit;
+        owner[slot] = i;
+        memcpy(rows + (slot << 3), tile, 8);
+      }
+    }
+  }
+  for (uint8_t i = 0; i < cells; i++) {
+    const uint8_t *tile = handle->_canvas_pixels[i];
+    if (codes[i] != 0xFF) {
+      continue;
+    }
+    for (uint8_t j = 0; j < i && codes[i] == 0xFF; j++) {
+      if (codes[j] < 8 && memcmp(handle->_canvas_pixels[j], tile, 8) == 0) {
+        codes[i] = codes[j];
+      }
+    }
+    if (codes[i] != 0xFF) {
+      continue;
+    }
+    // prefer the custom character the cell showed, so few rows change
+    const uint8_t current = handle->_canvas_codes[i];
+    uint8_t slot = current >= first && current < 8 && !(taken & (1 << current))
+                       ? current
+                       : 8;
+    for (uint8_t k = first; k < 8 && slot == 8; k++) {
+      if (!(taken & (1 << k))) {
+        slot = k;
+      }
+    }
+    if (slot == 8) {
+      codes[i] = ' ';
+      complete = false;
+      continue;
+    }
+    codes[i] = slot;
+    taken |= 1 << slot;
+    owner[slot] = i;
+    memcpy(rows + (slot << 3), tile, 8);
+  }
+  _lcd_write_cgram(handle, taken, rows);
+  for (uint8_t r = 0; r < handle->_canvas_rows; r++) {
+    _lcd_write_cells(handle, codes + r * handle->_canvas_cols,
+                     handle->_canvas_cols, handle->_canvas_col,
+                     handle->_canvas_row + r);
+  }
+  memcpy(handle->_canvas_codes, codes, cells);
+  memset(handle->_canvas_dirty, 0, sizeof(handle->_canvas_dirty));
+  _LCD_STATS_API_END(handle, LCD_API_CANVAS_FLUSH);
+  return complete;
+}
+
+/**
+ * @brief Prepares the sprite engine.
+ *
+ * Sprites are 5x8 pixel bitmaps placed at any pixel position. Every cell a
+ * visible sprite overlaps is shown with one of the custom characters
+ * `first_slot` to 7, which hold the sprites drawn over the character of the
+ * cell (custom characters only, ROM characters under a sprite are hidden).
+ * All sprites start hidden.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param first_slot First custom character used (0-7).
+ * @return true if the engine is ready, false if `first_slot` is invalid.
+ */
+bool lcd_sprite_init(LCD_Handle *handle, uint8_t first_slot) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (first_slot > 7) {
+    return false;
+  }
+  handle->_sprite_slot = first_slot;
+  handle->_sprite_ready = true;
+  for (uint8_t slot = first_slot; slot < 8; slot++) {
+    handle->_glyph_reserved |= 1 << slot;
+    handle->_glyph_codepoints[slot] = 0;
+    handle->_sprite_cells[slot] = 0xFF;
+  }
+  handle->_sprite_planned = 0;
+  for (uint8_t i = 0; i < LCD_MAX_SPRITES; i++) {
+    handle->_sprites[i].visible = false;
+  }
+  return true;
+}
+
+/**
+ * @brief Sets the bitmap of a sprite.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param id Sprite number (0 to LCD_MAX_SPRITES - 1).
+ * @param rows 8 pixel rows of 5 bits, like lcd_create_char().
+ */
+void lcd_sprite_set(LCD_Handle *handle, uint8_t id, const uint8_t *rows) {
+  if (handle == NULL || rows == NULL || id >= LCD_MAX_SPRITES) {
+    return;
+  }
+  for (uint8_t row = 0; row < 8; row++) {
+    handle->_sprites[id].rows[row] = rows[row] & 0x1F;
+  }
+}
+
+/**
+ * @brief Moves a sprite and makes it visible.
+ *
+ * Coordinates are pixels of the 5x8 grid of the cells, (0, 0) is the top left
+ * pixel of the display. Sprites may reach past the edges.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param id Sprite number (0 to LCD_MAX_SPRITES - 1).
+ * @param x Pixel column of the left edge of the sprite.
+ * @param y Pixel row of the top edge of the sprite.
+ */
+void lcd_sprite_move(LCD_Handle *handle, uint8_t id, int16_t x, int16_t y) {
+  if (handle == NULL || id >= LCD_MAX_SPRITES) {
+    return;
+  }
+  handle->_sprites[id].x = x;
+  handle->_sprites[id].y = y;
+  handle->_sprites[id].visible = true;
+}
+
+/**
+ * @brief Hides a sprite.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param id Sprite number (0 to LCD_MAX_SPRITES - 1).
+ */
+void lcd_sprite_hide(LCD_Handle *handle, uint8_t id) {
+  if (handle == NULL || id >= LCD_MAX_SPRITES) {
+    return;
+  }
+  handle->_sprites[id].visible = false;
+}
+
+/**
+ * @brief Shows the sprites at their current positions.
+ *
+ * Cells that stay covered keep their custom character, so moving a sprite
+ * within them only uploads the pixel rows that changed. Characters on the
+ * display are only written for cells that become covered or uncovered.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return true if the scene was shown, false if the sprites overlap more cells
+ *         than there are custom characters (the display is left unchanged) or
+ *         the display isn't ready.
+ */
+bool lcd_sprite_update(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (!handle->_sprite_ready ||
+      handle->_init_state != _LCD_INIT_READY) {
+    return false;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t first = handle->_sprite_slot;
+  uint8_t cells[4 * LCD_MAX_SPRITES];
+  const uint8_t count = _lcd_sprite_cells(handle, cells);
+  if (count > 8 - first) {
+    _LCD_STATS_API_END(handle, LCD_API_SPRITE_UPDATE);
+    return false;
+  }
+  // give back the cells that are no longer covered
+  for (uint8_t slot = first; slot < 8; slot++) {
+    const uint8_t cell = handle->_sprite_cells[slot];
+    if (cell == 0xFF || memchr(cells, cell, count) != NULL) {
+      continue;
+    }
+    _lcd_put_cell(handle, cell, handle->_sprite_backgrounds[slot],
+                  handle->_sprite_planned & (1 << slot));
+    _lcd_show_cells(handle, 1, cell % handle->_cols, cell / handle->_cols);
+    handle->_sprite_cells[slot] = 0xFF;
+    handle->_sprite_planned &= ~(1 << slot);
+  }
+  // cells covered before keep their custom character
+  uint8_t added = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    if (memchr(handle->_sprite_cells + first, cells[i], 8 - first) == NULL) {
+      cells[added++] = cells[i];
+    }
+  }
+  for (uint8_t i = 0, slot = first; i < added; i++) {
+    while (handle->_sprite_cells[slot] != 0xFF) {
+      slot++;
+    }
+    handle->_sprite_cells[slot] = cells[i];
+    handle->_sprite_backgrounds[slot] = handle->_frame[cells[i]];
+    if (handle->_attributes[cells[i]] & _LCD_ATTR_GLYPH) {
+      handle->_sprite_planned |= 1 << slot;
+    }
+  }
+  uint8_t rows[64];
+  uint8_t slots = 0;
+  for (uint8_t slot = first; slot < 8; slot++) {
+    if (handle->_sprite_cells[slot] != 0xFF) {
+      _lcd_sprite_composite(handle, handle->_sprite_cells[slot],
+                            handle->_sprite_backgrounds[slot],
+                            handle->_sprite_planned & (1 << slot),
+                            rows + (slot << 3));
+      slots |= 1 << slot;
+    }
+  }
+  _lcd_write_cgram(handle, slots, rows);
+  for (uint8_t slot = first; slot < 8; slot++) {
+    const uint8_t cell = handle->_sprite_cells[slot];
+    if (cell != 0xFF && memchr(cells, cell, added) != NULL) {
+      _lcd_write_cells(handle, &slot, 1, cell % handle->_cols,
+                       cell / handle->_cols);
+    }
+  }
+  _LCD_STATS_API_END(handle, LCD_API_SPRITE_UPDATE);
+  return true;
+}
+
+/**
+ * @brief Places a smooth scrolling ticker on the display.
+ *
+ * The text of the ticker is drawn with a built-in 5x7 font into the custom
+ * characters `first_slot` to `first_slot` + `cells` - 1, which are put on the
+ * display once. lcd_ticker_step() then moves the text by a single pixel and
+ * only rewrites CGRAM.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cells Width of the ticker in cells (1-8).
+ * @param first_slot First custom character used.
+ * @param col Column of the left end of the ticker (0-based index).
+ * @param row Row position (0-based index).
+ * @return true if the ticker was placed, false if it doesn't fit the custom
+ *         characters or the row.
+ */
+bool lcd_ticker_init(LCD_Handle *handle, uint8_t cells, uint8_t first_slot,
+                     uint8_t col, uint8_t row) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (cells == 0 || first_slot + cells > 8 || row >= handle->_numlines ||
+      col + cells > handle->_cols) {
+    return false;
+  }
+  handle->_ticker_cells = cells;
+  handle->_ticker_slot = first_slot;
+  handle->_ticker_text = NULL;
+  handle->_ticker_length = 0;
+  handle->_ticker_position = 0;
+  uint8_t codes[8];
+  for (uint8_t i = 0; i < cells; i++) {
+    codes[i] = first_slot + i;
+    handle->_glyph_reserved |= 1 << codes[i];
+    handle->_glyph_codepoints[codes[i]] = 0;
+  }
+  _lcd_render_ticker(handle);
+  _lcd_write_cells(handle, codes, cells, col, row);
+  return true;
+}
+
+/**
+ * @brief Sets the text of the ticker.
+ *
+ * The text enters from the right end of the ticker and scrolls out to the left,
+ * then starts over. The string is not copied and must stay valid while the
+ * ticker shows it. Characters outside of ASCII are shown as '?'.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param text Null-terminated string, NULL for a blank ticker.
+ */
+void lcd_ticker_text(LCD_Handle *handle, const char *text) {
+  if (handle == NULL) {
+    return;
+  }
+  const size_t length = text == NULL ? 0 : strlen(text);
+  handle->_ticker_text = text;
+  handle->_ticker_length = length > 10000 ? 10000 : length;
+  handle->_ticker_position = 0;
+  _lcd_render_ticker(handle);
+}
+
+/**
+ * @brief Moves the text of the ticker one pixel to the left.
+ *
+ * Only the CGRAM rows of the ticker that change are sent, 30 steps per second
+ * are far below the bus capacity.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_ticker_step(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  // the text scrolls through the blank ticker, 6 pixels per character
+  const uint32_t span =
+      handle->_ticker_cells * 5 + handle->_ticker_length * 6;
+  if (++handle->_ticker_position >= span) {
+    handle->_ticker_position = 0;
+  }
+  _lcd_render_ticker(handle);
+  _LCD_STATS_API_END(handle, LCD_API_TICKER_STEP);
+}
+
+/**
+ * @brief Animates a custom character.
+ *
+ * The custom character shows the frames one after the other, every cell that
+ * shows the character animates with it. A hardware alarm on the default alarm
+ * pool rewrites the rows of the character that change, the characters on the
+ * display are never touched; all animations due at the same time are sent in
+ * one burst. The alarm waits while a transfer of the calling core is in
+ * progress, so the display may be used normally from the core that runs the
+ * alarm pool, and it stops while the display is off. The burst is sent from
+ * the timer interrupt and busy-waits for the display: with the RW pin about
+ * 40 us per changed row, without it 200 us (4-bit) or 100 us (8-bit).
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param slot Custom character to animate (0-7), it is reserved from then on.
+ * @param frames `count` frames of 8 pixel rows, not copied.
+ * @param count Number of frames.
+ * @param period_ms Time each frame is shown, in milliseconds.
+ * @return true if the animation runs (or waits for the display to be turned
+ *         on), false if the arguments are invalid, the display isn't ready or no
+ *         alarm is available.
+ */
+bool lcd_animate(LCD_Handle *handle, uint8_t slot, const uint8_t *frames,
+                 uint8_t count, uint32_t period_ms) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (slot > 7 || frames == NULL || count == 0 || period_ms == 0 ||
+      handle->_init_state != _LCD_INIT_READY) {
+    return false;
+  }
+  LCD_Animation *animation = &handle->_animations[slot];
+  // the alarm skips the animation until it is complete
+  animation->count = 0;
+  animation->frames = frames;
+  animation->frame = 0;
+  animation->period_us = period_ms * 1000;
+  animation->due_us = time_us_64() + animation->period_us;
+  handle->_glyph_reserved |= 1 << slot;
+  handle->_glyph_codepoints[slot] = 0;
+  uint8_t rows[64];
+  memcpy(rows + (slot << 3), frames, 8);
+  _lcd_write_cgram(handle, 1 << slot, rows);
+  animation->count = count;
+  _lcd_start_animations(handle);
+  return handle->_animation_alarm > 0 ||
+         !(handle->_sent_displaycontrol & LCD_DISPLAYON);
+}
+
+/**
+ * @brief Stops the animation of a custom character.
+ *
+ * The character keeps showing the current frame.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param slot Animated custom character (0-7).
+ */
+void lcd_animate_stop(LCD_Handle *handle, uint8_t slot) {
+  if (handle == NULL || slot > 7) {
+    return;
+  }
+  handle->_animations[slot].count = 0;
+}
+
+/**
+ * @brief Creates a custom character on the LCD.
+ *
+ * This function defines a new custom character pattern in the LCD's CGRAM (Character Generator RAM).
+ * The pattern is specified by the `data` array and can be used later to display the custom character.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param num Character code for the custom character (0-7 for most LCDs).
+ * @param data Array of 8 bytes representing the custom character pattern. Each byte corresponds
+ *             to one row of the character (8 rows in total).
+ */
+void lcd_create_char(LCD_Handle *handle, uint8_t num, uint8_t *data) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t ddram_address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  uint8_t gcram_address = (num & 0x7) << 3;
   for (size_t i = 0; i < 8; i++) {
     _lcd_send_command(handle, LCD_SETCGRAMADDR | (gcram_address + i));
     _lcd_send_data(handle, data[i]);
   }
-  if (handle->_rw_pin != 255) {
-    _lcd_send_command(handle, LCD_SETDDRAMADDR | ddram_address);
+  handle->_cgram_valid |= 1 << (num & 0x7);
+  // the glyph cache must not reuse the character
+  handle->_glyph_reserved |= 1 << (num & 0x7);
+  handle->_glyph_codepoints[num & 0x7] = 0;
+  if (!cgram_selected) {
+    _lcd_send_command(handle, LCD_SETDDRAMADDR | ddram_address);
+  }
+  _LCD_STATS_API_END(handle, LCD_API_CREATE_CHAR);
+}
+
+/**
+ * @brief Fills the frame buffer with spaces.
+ *
+ * The attributes of all cells are removed as well, open windows are composed
+ * again by the next lcd_flush(). This function only updates the frame buffer.
+ * Clearing the frame buffer and drawing the next screen into it makes
+ * lcd_flush() send just the characters that changed, so redrawing a similar
+ * layout doesn't flash the display like lcd_clear() would.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_buffer_clear(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  memset(handle->_frame, ' ', (size_t)handle->_cols * handle->_numlines);
+  memset(handle->_attributes, 0, (size_t)handle->_cols * handle->_numlines);
+  handle->_attribute_cells = 0;
+  _lcd_touch_windows(handle);
+}
+
+/**
+ * @brief Puts a single character into the frame buffer.
+ *
+ * This function only updates the frame buffer, the display shows the character after
+ * the next lcd_flush(). Positions outside the display are ignored.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param symbol Character to be displayed.
+ * @param col Column position (0-based index).
+ * @param row Row position (0-based index).
+ */
+void lcd_buffer_char_at(LCD_Handle *handle, char symbol, uint8_t col,
+                        uint8_t row) {
+  if (handle == NULL || col >= handle->_cols || row >= handle->_numlines) {
+    return;
+  }
+  _lcd_put_cell(handle, row * handle->_cols + col, symbol, false);
+}
+
+/**
+ * @brief Puts a string into the frame buffer.
+ *
+ * This function only updates the frame buffer, the display shows the text after the
+ * next lcd_flush(). The text is clipped at the end of the row.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param text Null-terminated string to be displayed.
+ * @param col Column position (0-based index).
+ * @param row Row position (0-based index).
+ */
+void lcd_buffer_string_at(LCD_Handle *handle, const char *text, uint8_t col,
+                          uint8_t row) {
+  if (handle == NULL || row >= handle->_numlines) {
+    return;
+  }
+  const size_t offset = (size_t)row * handle->_cols;
+  uint8_t codes[2];
+  while (*text != '\0' && col < handle->_cols) {
+    const uint32_t codepoint = _lcd_decode(handle, &text);
+    // characters drawn into CGRAM are assigned slots by lcd_flush()
+    const int index = _lcd_plan_glyph(handle, codepoint);
+    if (index >= 0) {
+      _lcd_put_cell(handle, offset + col++, index, true);
+      continue;
+    }
+    const uint8_t count = _lcd_translate(handle, codepoint, codes);
+    for (uint8_t i = 0; i < count && col < handle->_cols; i++) {
+      _lcd_put_cell(handle, offset + col++, codes[i], false);
+    }
+  }
+}
+
+/**
+ * @brief Sets the attributes of a run of cells.
+ *
+ * The HD44780 can only blink the cursor cell. Cells with LCD_ATTR_BLINK show a
+ * space instead of their character for the second half of every
+ * LCD_BLINK_PERIOD_MS, and cells with LCD_ATTR_INVERSE show their character as
+ * an inverted glyph from the glyph cache (ASCII characters only, others and
+ * cells without a free CGRAM slot are shown as they are). The attributes are
+ * applied when the cells are drawn, by lcd_flush() and the lcd_write_*_at()
+ * functions of numbers, big characters and bars. Nothing blinks on its own:
+ * the phase is only looked at when cells are drawn, so lcd_flush() must be
+ * called at least every LCD_BLINK_PERIOD_MS / 2 for an even blink. Characters
+ * written with lcd_write_char() or lcd_write_string() are shown plain until
+ * the next flush.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param attributes Combination of LCD_ATTR_BLINK and LCD_ATTR_INVERSE, 0 to
+ *                   remove the attributes.
+ * @param width Number of cells, clipped at the end of the row.
+ * @param col Column of the first cell (0-based index).
+ * @param row Row of the cells (0-based index).
+ */
+void lcd_set_attributes_at(LCD_Handle *handle, uint8_t attributes,
+                           uint8_t width, uint8_t col, uint8_t row) {
+  if (handle == NULL || col >= handle->_cols || row >= handle->_numlines) {
+    return;
+  }
+  if (width > handle->_cols - col) {
+    width = handle->_cols - col;
+  }
+  attributes &= LCD_ATTR_BLINK | LCD_ATTR_INVERSE;
+  uint8_t *cells = handle->_attributes + row * handle->_cols + col;
+  for (uint8_t i = 0; i < width; i++) {
+    const uint8_t value = attributes | (cells[i] & _LCD_ATTR_GLYPH);
+    handle->_attribute_cells += (value != 0) - (cells[i] != 0);
+    cells[i] = value;
+  }
+}
+
+/**
+ * @brief Opens a window over the frame buffer.
+ *
+ * Windows let independent parts of the firmware share the display: each one
+ * draws into its own rectangle with its own coordinates, clipped at the edges
+ * of the window. The cells are kept in the caller's buffer, and lcd_flush()
+ * composes the cells changed since the last flush into the frame buffer, where
+ * higher windows hide lower ones. Cells no window covers are left to
+ * lcd_buffer_char_at() and lcd_buffer_string_at(). The window starts blank.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param window Window to open, owned by the caller.
+ * @param cells Buffer of LCD_WINDOW_SIZE(width, height) bytes for the cells.
+ * @param col Column of the top left cell (0-based index).
+ * @param row Row of the top left cell (0-based index).
+ * @param width Width in cells.
+ * @param height Height in cells.
+ * @param z Stacking order, higher windows hide lower ones. A window opened
+ *          later hides windows with the same z.
+ * @return true if the window was opened, false if it doesn't fit the display
+ *         or is open already.
+ */
+bool lcd_window_open(LCD_Handle *handle, LCD_Window *window, uint8_t *cells,
+                     uint8_t col, uint8_t row, uint8_t width, uint8_t height,
+                     uint8_t z) {
+  if (handle == NULL || window == NULL || cells == NULL || width == 0 ||
+      height == 0 || col + width > handle->_cols ||
+      row + height > handle->_numlines) {
+    return false;
+  }
+  LCD_Window **link = &handle->_windows;
+  for (LCD_Window *other = handle->_windows; other != NULL;
+       other = other->next) {
+    if (other == window) {
+      return false;
+    }
+    // windows are sorted topmost first
+    if (other->z > z) {
+      link = &other->next;
+    }
+  }
+  const size_t size = (size_t)width * height;
+  memset(cells, ' ', size);
+  memset(cells + size, 0, size);
+  window->cells = cells;
+  window->col = col;
+  window->row = row;
+  window->width = width;
+  window->height = height;
+  window->z = z;
+  window->dirty_left = 0xFF;
+  window->dirty_right = 0;
+  _lcd_touch_window(window, 0, 0, width, height);
+  window->next = *link;
+  *link = window;
+  return true;
+}
+
+/**
+ * @brief Closes a window.
+ *
+ * The cells the window covered show the windows below it again right away,
+ * composed from their cell buffers into the frame buffer, so they don't need
+ * to be drawn again. Cells no other window covers become blank. The display
+ * changes with the next lcd_flush().
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param window Window opened by lcd_window_open().
+ */
+void lcd_window_close(LCD_Handle *handle, LCD_Window *window) {
+  if (handle == NULL || window == NULL) {
+    return;
+  }
+  LCD_Window **link = &handle->_windows;
+  while (*link != NULL && *link != window) {
+    link = &(*link)->next;
+  }
+  if (*link == NULL) {
+    return;
+  }
+  *link = window->next;
+  window->next = NULL;
+  for (uint8_t row = 0; row < window->height; row++) {
+    for (uint8_t col = 0; col < window->width; col++) {
+      _lcd_compose_cell(handle, window->col + col, window->row + row);
+    }
+  }
+}
+
+/**
+ * @brief Fills a window with spaces and removes the attributes of its cells.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param window Window opened by lcd_window_open().
+ */
+void lcd_window_clear(LCD_Handle *handle, LCD_Window *window) {
+  if (handle == NULL || window == NULL || window->cells == NULL) {
+    return;
+  }
+  for (uint8_t row = 0; row < window->height; row++) {
+    for (uint8_t col = 0; col < window->width; col++) {
+      _lcd_window_put(window, col, row, ' ', 0);
+    }
+  }
+}
+
+/**
+ * @brief Puts a single character into a window.
+ *
+ * The display shows the character after the next lcd_flush() unless a higher
+ * window covers it. Positions outside the window are ignored.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param window Window opened by lcd_window_open().
+ * @param symbol Character to be displayed.
+ * @param col Column position in the window (0-based index).
+ * @param row Row position in the window (0-based index).
+ */
+void lcd_window_char_at(LCD_Handle *handle, LCD_Window *window, char symbol,
+                        uint8_t col, uint8_t row) {
+  if (handle == NULL || window == NULL || window->cells == NULL ||
+      col >= window->width || row >= window->height) {
+    return;
+  }
+  const size_t size = (size_t)window->width * window->height;
+  const uint8_t attributes =
+      window->cells[size + row * window->width + col] & ~_LCD_ATTR_GLYPH;
+  _lcd_window_put(window, col, row, symbol, attributes);
+}
+
+/**
+ * @brief Puts a string into a window.
+ *
+ * The text is translated like lcd_buffer_string_at() does and clipped at the
+ * right edge of the window. The display shows it after the next lcd_flush()
+ * where no higher window covers it.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param window Window opened by lcd_window_open().
+ * @param text Null-terminated string to be displayed.
+ * @param col Column position in the window (0-based index).
+ * @param row Row position in the window (0-based index).
+ */
+void lcd_window_string_at(LCD_Handle *handle, LCD_Window *window,
+                          const char *text, uint8_t col, uint8_t row) {
+  if (handle == NULL || window == NULL || window->cells == NULL ||
+      row >= window->height) {
+    return;
+  }
+  const size_t size = (size_t)window->width * window->height;
+  const uint8_t *attributes = window->cells + size + row * window->width;
+  uint8_t codes[2];
+  while (*text != '\0' && col < window->width) {
+    const uint32_t codepoint = _lcd_decode(handle, &text);
+    const int index = _lcd_plan_glyph(handle, codepoint);
+    if (index >= 0) {
+      _lcd_window_put(window, col, row, index,
+                      attributes[col] | _LCD_ATTR_GLYPH);
+      col++;
+      continue;
+    }
+    const uint8_t count = _lcd_translate(handle, codepoint, codes);
+    for (uint8_t i = 0; i < count && col < window->width; i++, col++) {
+      _lcd_window_put(window, col, row, codes[i],
+                      attributes[col] & ~_LCD_ATTR_GLYPH);
+    }
+  }
+}
+
+/**
+ * @brief Sets the attributes of a run of cells of a window.
+ *
+ * Works like lcd_set_attributes_at() in window coordinates, the attributes are
+ * composed into the frame buffer together with the characters.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param window Window opened by lcd_window_open().
+ * @param attributes Combination of LCD_ATTR_BLINK and LCD_ATTR_INVERSE, 0 to
+ *                   remove the attributes.
+ * @param width Number of cells, clipped at the right edge of the window.
+ * @param col Column of the first cell in the window (0-based index).
+ * @param row Row of the cells in the window (0-based index).
+ */
+void lcd_window_set_attributes_at(LCD_Handle *handle, LCD_Window *window,
+                                  uint8_t attributes, uint8_t width,
+                                  uint8_t col, uint8_t row) {
+  if (handle == NULL || window == NULL || window->cells == NULL ||
+      col >= window->width || row >= window->height) {
+    return;
+  }
+  if (width > window->width - col) {
+    width = window->width - col;
+  }
+  attributes &= LCD_ATTR_BLINK | LCD_ATTR_INVERSE;
+  const size_t size = (size_t)window->width * window->height;
+  const size_t offset = (size_t)row * window->width;
+  for (uint8_t i = col; i < col + width; i++) {
+    _lcd_window_put(window, i, row, window->cells[offset + i],
+                    attributes |
+                        (window->cells[size + offset + i] & _LCD_ATTR_GLYPH));
+  }
+}
+
+/**
+ * @brief Sends the changes in the frame buffer to the LCD.
+ *
+ * This function compares the frame buffer with the shadow copy of the display and
+ * writes only the cells that differ, setting the address once per run of changed
+ * cells. The entry mode and the cursor position are restored afterwards. The
+ * cells of open windows that changed are composed into the frame buffer first.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _LCD_RAM_FUNC(lcd_flush)(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  _lcd_compose(handle);
+  _lcd_plan_screen(handle);
+  _lcd_flush_frame(handle, true);
+  _LCD_STATS_API_END(handle, LCD_API_FLUSH);
+}
+
+#if LCD_CONFIG_RUN_FROM_RAM
+/**
+ * @brief Sends the changes in the frame buffer to the LCD without touching flash.
+ *
+ * This function works like lcd_flush(), but it runs entirely from SRAM, so it
+ * can be called while the other core is erasing or programming flash. The call
+ * isn't added to the API counters and latency histograms, the transfers still
+ * update the bus counters. Cells with attributes are left as they are, as
+ * drawing them needs the font and the glyph cache, and windows aren't
+ * composed. Only available with LCD_CONFIG_RUN_FROM_RAM=1.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void __no_inline_not_in_flash_func(lcd_flush_flash_safe)(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+  _lcd_flush_frame(handle, false);
+}
+#endif
+
+/**
+ * @brief Reads the characters shown on the LCD.
+ *
+ * This function reads the visible part of the DDRAM back from the controller,
+ * which also shows anything the library doesn't know about. The address is set
+ * once per run of rows that follow each other in DDRAM and the characters are
+ * streamed with the address counter auto-incrementing. The cursor position and
+ * the entry mode are restored afterwards. Requires the RW pin.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param buffer Buffer for the characters, row-major without terminators.
+ * @param size Size of the buffer, at least columns * rows bytes.
+ * @return true if the screen was read.
+ */
+bool lcd_read_screen(LCD_Handle *handle, char *buffer, size_t size) {
+  if (handle == NULL || buffer == NULL || !_LCD_HAS_RW(handle) ||
+      handle->_init_state != _LCD_INIT_READY ||
+      size < (size_t)handle->_cols * handle->_numlines) {
+    return false;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  const uint8_t displaymode = _lcd_begin_sequential(handle);
+  _lcd_read_ddram(handle, (uint8_t *)buffer);
+  _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+  _LCD_STATS_API_END(handle, LCD_API_READ_SCREEN);
+  return true;
+}
+
+/**
+ * @brief Reads the patterns of the custom characters from the LCD.
+ *
+ * This function reads the whole CGRAM with a single address set, in the layout
+ * used by lcd_create_char(): 8 rows per character, 5 bits per row. The cursor
+ * position and the entry mode are restored afterwards. Requires the RW pin.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param buffer Buffer for the patterns.
+ * @param size Size of the buffer, at least 64 bytes.
+ * @return true if the patterns were read.
+ */
+bool lcd_read_glyphs(LCD_Handle *handle, uint8_t *buffer, size_t size) {
+  if (handle == NULL || buffer == NULL || !_LCD_HAS_RW(handle) ||
+      handle->_init_state != _LCD_INIT_READY || size < 64) {
+    return false;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  const uint8_t displaymode = _lcd_begin_sequential(handle);
+  _lcd_read_cgram(handle, buffer);
+  _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+  _LCD_STATS_API_END(handle, LCD_API_READ_GLYPHS);
+  return true;
+}
+
+/**
+ * @brief Verifies a few characters on the LCD and repairs corrupted ones.
+ *
+ * This function is meant to be called periodically from idle time. Each call
+ * reads back up to `budget` characters (visible cells, then the rows of the
+ * custom characters created with lcd_create_char()), continuing where the last
+ * call stopped, and rewrites those that differ from the shadow copy. Before
+ * that, the same probe as in lcd_attach() checks that the controller still uses
+ * the configured interface; if it doesn't (e.g. ESD reset it into 8-bit mode),
+ * the display is initialized again and its whole state is restored. The probe
+ * reads a character as well and counts against the budget. The cursor position
+ * and the entry mode are kept. Requires the RW pin.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param budget Maximum number of characters to read back in this call,
+ *               including the probe. Nothing is read if it is 0.
+ * @return int Number of characters that were rewritten, LCD_SCRUB_RESTORED if
+ *         the controller had to be initialized again.
+ */
+int lcd_scrub(LCD_Handle *handle, uint8_t budget) {
+  if (handle == NULL || !_LCD_HAS_RW(handle) ||
+      handle->_init_state != _LCD_INIT_READY || budget == 0) {
+    return 0;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  const uint8_t address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  const uint8_t displaymode = _lcd_begin_sequential(handle);
+  if (!_lcd_probe(handle)) {
+    _lcd_restore(handle, displaymode, address, cgram_selected);
+    _LCD_STATS_ADD(handle, scrub_restores, 1);
+    _LCD_STATS_API_END(handle, LCD_API_SCRUB);
+    return LCD_SCRUB_RESTORED;
+  }
+  budget--;
+
+  const uint16_t cells = (uint16_t)handle->_cols * handle->_numlines;
+  int repaired = 0;
+  while (budget > 0) {
+    const uint16_t position = handle->_scrub_position;
+    handle->_scrub_position = (position + 1) % (cells + 64);
+    uint8_t command;
+    uint8_t expected;
+    if (position < cells) {
+      const uint8_t row = position / handle->_cols;
+      command = LCD_SETDDRAMADDR |
+                (handle->_row_offsets[row] + position % handle->_cols);
+      expected = handle->_shadow[position];
+    } else {
+      const uint8_t index = position - cells;
+      if (!(handle->_cgram_valid & (1 << (index >> 3)))) {
+        continue;
+      }
+      command = LCD_SETCGRAMADDR | index;
+      expected = handle->_cgram[index];
+    }
+    budget--;
+
+    const bool cgram = command < LCD_SETDDRAMADDR;
+    if (handle->_cgram_selected != cgram ||
+        handle->_address != (command & (cgram ? 0x3F : 0x7F))) {
+      _lcd_send_command(handle, command);
+    }
+    const uint8_t mask = cgram ? 0x1F : 0xFF;
+    if ((_lcd_read_data(handle) & mask) != expected) {
+      _lcd_send_command(handle, command);
+      handle->_redrawing = true;
+      _lcd_send_data(handle, expected);
+      handle->_redrawing = false;
+      repaired++;
+    }
+  }
+  if (repaired > 0) {
+    // whatever corrupted the memory may have hit the settings as well
+    _lcd_send_command(handle, LCD_FUNCTIONSET | handle->_displayfunction);
+    _lcd_send_command(handle,
+                      LCD_DISPLAYCONTROL | handle->_sent_displaycontrol);
+    _LCD_STATS_ADD(handle, scrub_repairs, repaired);
+  }
+  _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+  _LCD_STATS_API_END(handle, LCD_API_SCRUB);
+  return repaired;
+}
+
+/**
+ * @brief Starts recording the transfers to the display into a stream.
+ *
+ * Everything the following lcd_* calls send is still sent to the display and is
+ * also appended to `buffer`, already encoded for the bus width of the display
+ * (see LCD_STREAM_4BIT and LCD_STREAM_8BIT), together with the waits for the
+ * clear and return home instructions. lcd_replay() sends the stream again
+ * later. Settings the controller already holds are recorded anyway, and
+ * lcd_clear() always records the clear instruction, so the stream doesn't depend
+ * on the state of the display when it is replayed.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param buffer Buffer for the stream.
+ * @param size Size of `buffer` in bytes.
+ * @return true if recording started, false before the display is ready or if
+ *         `buffer` is missing.
+ */
+bool lcd_record_begin(LCD_Handle *handle, uint8_t *buffer, size_t size) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (buffer == NULL || size == 0 ||
+      handle->_init_state != _LCD_INIT_READY) {
+    return false;
+  }
+  handle->_record = buffer;
+  handle->_record_size = size;
+  handle->_record_length = 0;
+  _lcd_record_byte(handle,
+                   _LCD_8BIT(handle) ? LCD_STREAM_8BIT : LCD_STREAM_4BIT);
+  // make the next character record the entry mode it needs
+  handle->_sent_displaymode = 0xFF;
+  return true;
+}
+
+/**
+ * @brief Stops recording started with lcd_record_begin().
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return size_t Length of the recorded stream in bytes, or 0 if it didn't fit
+ *         into the buffer or nothing was recorded.
+ */
+size_t lcd_record_end(LCD_Handle *handle) {
+  if (handle == NULL || handle->_record == NULL) {
+    return 0;
+  }
+  const size_t length = handle->_record_length;
+  const size_t size = handle->_record_size;
+  handle->_record = NULL;
+  return length <= size ? length : 0;
+}
+
+/**
+ * @brief Sends a stream recorded with lcd_record_begin().
+ *
+ * The stream can be kept in flash as a const array. Its nibbles or bytes are
+ * put on the bus as they were encoded, then the transfers are tracked in one
+ * pass, so buffered drawing, lcd_clear() and lcd_scrub() know what the display
+ * shows afterwards. Display control and entry mode settings in the stream
+ * become the current settings.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param stream Recorded stream.
+ * @param length Length of the stream in bytes.
+ * @return true if the whole stream was sent, false before the display is ready,
+ *         if the stream was recorded for the other bus width or if it ends in
+ *         the middle of a transfer.
+ */
+bool lcd_replay(LCD_Handle *handle, const uint8_t *stream, size_t length) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (stream == NULL || length == 0 ||
+      handle->_init_state != _LCD_INIT_READY ||
+      stream[0] != (_LCD_8BIT(handle) ? LCD_STREAM_8BIT : LCD_STREAM_4BIT)) {
+    return false;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  // the alarms must not touch the bus before the stream is tracked
+  handle->_bus_depth++;
+  if (handle->_sent_displaymode != handle->_displaymode) {
+    // a pending entry mode change applies to the data of the stream as well
+    _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  }
+  const size_t sent = _lcd_replay_transfers(handle, stream, length);
+  _lcd_replay_track(handle, stream, sent);
+  handle->_bus_depth--;
+  _LCD_STATS_API_END(handle, LCD_API_REPLAY);
+  return sent == length;
+}
+
+/**
+ * @brief Writes text into a field of a stream generated by tools/lcd_screenc.py.
+ *
+ * The characters are encoded in place, so replaying the stream afterwards shows
+ * the screen with the new field content without formatting the rest of it. Shorter
+ * text is padded with spaces, longer text is cut off at the field width.
+ *
+ * @param stream Stream in RAM.
+ * @param length Length of the stream in bytes.
+ * @param field Field of the stream.
+ * @param text Null-terminated text.
+ * @return true if the field was patched, false if it doesn't lie in the stream.
+ */
+bool lcd_stream_patch(uint8_t *stream, size_t length,
+                      const LCD_StreamField *field, const char *text) {
+  if (stream == NULL || field == NULL || text == NULL) {
+    return false;
+  }
+  // both encodings take two bytes per character
+  if ((size_t)field->offset + 2 * field->width > length ||
+      field->offset == 0 || !(stream[field->offset] & LCD_STREAM_RS)) {
+    return false;
+  }
+  const bool eightbit = stream[0] == LCD_STREAM_8BIT;
+  uint8_t *cell = stream + field->offset;
+  for (uint8_t i = 0; i < field->width; i++, cell += 2) {
+    const uint8_t symbol = *text != '\0' ? (uint8_t)*text++ : ' ';
+    if (eightbit) {
+      cell[0] = LCD_STREAM_RS;
+      cell[1] = symbol;
+    } else {
+      cell[0] = LCD_STREAM_RS | (symbol >> 4);
+      cell[1] = LCD_STREAM_RS | (symbol & 0x0F);
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Shows a field of a stream on the screen the stream already put up.
+ *
+ * Replaying the whole stream clears the display first. After lcd_stream_patch()
+ * on a screen that is already shown, this function writes only the characters
+ * of the field that differ from the display, at the position of the field.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param stream Stream generated by tools/lcd_screenc.py.
+ * @param length Length of the stream in bytes.
+ * @param field Field of the stream.
+ * @return true if the field was written, false if it doesn't lie in the stream
+ *         or on the display.
+ */
+bool lcd_replay_field(LCD_Handle *handle, const uint8_t *stream, size_t length,
+                      const LCD_StreamField *field) {
+  if (handle == NULL) {
+    return false;
+  }
+  if (stream == NULL || field == NULL ||
+      (size_t)field->offset + 2 * field->width > length ||
+      field->offset == 0 || !(stream[field->offset] & LCD_STREAM_RS) ||
+      field->row >= handle->_numlines || field->col >= handle->_cols ||
+      field->width > handle->_cols - field->col) {
+    return false;
+  }
+  _LCD_STATS_API_BEGIN(handle);
+  // both encodings take two bytes per character
+  const bool eightbit = stream[0] == LCD_STREAM_8BIT;
+  const uint8_t *cell = stream + field->offset;
+  uint8_t text[40];
+  for (uint8_t i = 0; i < field->width; i++, cell += 2) {
+    text[i] = eightbit ? cell[1] : (uint8_t)(cell[0] << 4) | (cell[1] & 0x0F);
+  }
+  _lcd_write_cells(handle, text, field->width, field->col, field->row);
+  _LCD_STATS_API_END(handle, LCD_API_REPLAY_FIELD);
+  return true;
+}
+
+/**
+ * @brief Copies the performance counters of the LCD.
+ *
+ * The counters are only maintained when the library is built with
+ * LCD_ENABLE_STATS=1. Otherwise the snapshot is zeroed and false is returned.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param stats Pointer to the structure receiving the snapshot.
+ * @return true if the counters are available, false otherwise.
+ */
+bool lcd_get_stats(LCD_Handle *handle, LCD_Stats *stats) {
+  if (stats == NULL) {
+    return false;
+  }
+#if LCD_ENABLE_STATS
+  if (handle != NULL) {
+    *stats = handle->_stats;
+    return true;
+  }
+#else
+  (void)handle;
+#endif
+  memset(stats, 0, sizeof(*stats));
+  return false;
+}
+
+/**
+ * @brief Resets the performance counters of the LCD.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_reset_stats(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+#if LCD_ENABLE_STATS
+  memset(&handle->_stats, 0, sizeof(handle->_stats));
+#endif
+}
+
+/**
+ * @brief Prints the trace ring buffer to stdout.
+ *
+ * This function writes the recorded bus transfers, oldest first, as text lines
+ * "<time_us> <R|W> <C|D> <4|8> <value>" (value in hex). The output of a UART
+ * console can be converted to a VCD file with tools/lcd_trace2vcd.py.
+ * Nothing is printed unless the library is built with LCD_ENABLE_TRACE=1.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_trace_dump(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+#if LCD_ENABLE_TRACE
+  const uint32_t count = handle->_trace_count;
+  const uint32_t first = count > LCD_TRACE_DEPTH ? count - LCD_TRACE_DEPTH : 0;
+  printf("# lcd-trace v1 entries=%lu dropped=%lu\n",
+         (unsigned long)(count - first), (unsigned long)first);
+  for (uint32_t i = first; i != count; i++) {
+    const LCD_TraceEntry entry = handle->_trace[i & (LCD_TRACE_DEPTH - 1)];
+    printf("%lu %c %c %c %02X\n", (unsigned long)entry.time_us,
+           (entry.flags & LCD_TRACE_READ) ? 'R' : 'W',
+           (entry.flags & LCD_TRACE_RS) ? 'D' : 'C',
+           (entry.flags & LCD_TRACE_NIBBLE) ? '4' : '8', entry.value);
+  }
+  printf("# lcd-trace end\n");
+#endif
+}
+
+/**
+ * @brief Discards all transfers recorded in the trace ring buffer.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void lcd_trace_clear(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return;
+  }
+#if LCD_ENABLE_TRACE
+  handle->_trace_count = 0;
+#endif
+}
+
+// ########################################################################## //
+//                                                                            //
+//                      Private function implementation                       //
+//                                                                            //
+// ########################################################################## //
+
+/**
+ * @brief Initializes the LCD with the specified settings and returns a handle.
+ *
+ * This function sets up the LCD controller with the given parameters such as
+ * the number of columns and rows, character size, and GPIO pin assignments.
+ * It configures the pins and returns a pointer to the LCD handle, the
+ * initialization sequence as specified in the LCD datasheet is then run by
+ * lcd_init_poll() or _lcd_finish_init().
+ *
+ * @param storage Pointer to the storage for the handle, or NULL to allocate it on the heap.
+ * @param storage_size Size of the storage in bytes (ignored if `storage` is NULL).
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param d0 GPIO pin number for data line 0.
+ * @param d1 GPIO pin number for data line 1.
+ * @param d2 GPIO pin number for data line 2.
+ * @param d3 GPIO pin number for data line 3.
+ * @param d4 GPIO pin number for data line 4.
+ * @param d5 GPIO pin number for data line 5.
+ * @param d6 GPIO pin number for data line 6.
+ * @param d7 GPIO pin number for data line 7.
+ * @param eightbitmode Boolean flag to specify if 8-bit mode is used.
+ * @return LCD_Handle* Pointer to the initialized LCD handle, or NULL if initialization failed.
+ */
+LCD_Handle *_lcd_init(void *storage, size_t storage_size, uint8_t cols,
+                      uint8_t rows, uint8_t charsize, uint8_t rs, uint8_t rw,
+                      uint8_t enable, uint8_t d0, uint8_t d1, uint8_t d2,
+                      uint8_t d3, uint8_t d4, uint8_t d5, uint8_t d6,
+                      uint8_t d7, bool eightbitmode) {
+  if (cols == 0 || cols > 40 || rows == 0 || rows > 4) {
+    return NULL;
+  }
+  const uint8_t data_pins[8] = {d0, d1, d2, d3, d4, d5, d6, d7};
+  if (!_lcd_config_matches(rs, rw, enable, data_pins, eightbitmode)) {
+    return NULL;
+  }
+  LCD_Handle *handle = (LCD_Handle *)storage;
+  if (handle == NULL) {
+    handle = (LCD_Handle *)malloc(LCD_STORAGE_SIZE(cols, rows));
+    if (handle == NULL) {
+      return NULL;
+    }
+  } else if (storage_size < LCD_STORAGE_SIZE(cols, rows)) {
+    return NULL;
+  }
+  memset(handle, 0, sizeof(LCD_Handle));
+  handle->_static = storage != NULL;
+  handle->_cols = cols;
+  handle->_shadow = (uint8_t *)(handle + 1);
+  handle->_frame = handle->_shadow + cols * rows;
+  handle->_attributes = handle->_frame + cols * rows;
+  memset(handle->_shadow, ' ', 2 * cols * rows);
+  memset(handle->_attributes, 0, cols * rows);
+
+  // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
+  // according to datasheet, we need at least 40 ms after power rises above 2.7
+  // V before sending commands. Microcontroller can turn on way before 4.5 V so
+  // we'll wait until 50 ms after boot, which has long passed on a re-init
+  handle->_init_state = _LCD_INIT_FUNCTIONSET_1;
+  handle->_init_deadline = 50000;
+
+  handle->_rs_pin = rs;
+  handle->_rw_pin = rw;
+  handle->_enable_pin = enable;
+
+  handle->_data_pins[0] = d0;
+  handle->_data_pins[1] = d1;
+  handle->_data_pins[2] = d2;
+  handle->_data_pins[3] = d3;
+  handle->_data_pins[4] = d4;
+  handle->_data_pins[5] = d5;
+  handle->_data_pins[6] = d6;
+  handle->_data_pins[7] = d7;
+
+  if (eightbitmode) {
+    handle->_displayfunction = LCD_8BITMODE | LCD_1LINE | LCD_5x8DOTS;
+    handle->_data_pins_mask = (0x1 << d0) | (0x1 << d1) | (0x1 << d2) |
+                              (0x1 << d3) | (0x1 << d4) | (0x1 << d5) |
+                              (0x1 << d6) | (0x1 << d7);
+  } else {
+    handle->_displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
+    handle->_data_pins_mask =
+        (0x1 << d0) | (0x1 << d1) | (0x1 << d2) | (0x1 << d3);
+  }
+
+  _lcd_init_pins(handle);
+  _lcd_setup(handle, cols, rows, charsize);
+
+  return handle;
+}
+
+/**
+ * @brief Runs the initialization sequence of the LCD to the end.
+ *
+ * This function sleeps until each step of the sequence is due, which is what
+ * the blocking lcd_init_*() functions do.
+ *
+ * @param handle Pointer to the LCD handle returned by _lcd_init(), or NULL.
+ * @return LCD_Handle* The handle, or NULL if `handle` is NULL.
+ */
+LCD_Handle *_lcd_finish_init(LCD_Handle *handle) {
+  if (handle == NULL) {
+    return NULL;
+  }
+  while (!lcd_init_poll(handle)) {
+    sleep_until(from_us_since_boot(handle->_init_deadline));
+  }
+  return handle;
+}
+
+/**
+ * @brief Runs one step of the initialization sequence.
+ *
+ * The function set is sent three times in 8-bit mode, as the controller may be
+ * in any interface mode after power-on, then the 4-bit interface is selected if
+ * needed and the display is configured and cleared (which also returns home).
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return uint32_t Time in microseconds before the next step may run.
+ */
+uint32_t _lcd_init_step(LCD_Handle *handle) {
+  const uint8_t state = handle->_init_state++;
+  switch (state) {
+    case _LCD_INIT_FUNCTIONSET_1:
+    case _LCD_INIT_FUNCTIONSET_2:
+    case _LCD_INIT_FUNCTIONSET_3:
+      if (_LCD_8BIT(handle)) {
+        // this is according to the Hitachi HD44780 datasheet
+        // page 45 figure 23
+        _lcd_write_8_bits(handle, LCD_FUNCTIONSET | handle->_displayfunction);
+      } else {
+        // this is according to the Hitachi HD44780 datasheet
+        // page 46 figure 24, we start in 8bit mode
+        _lcd_write_4_bits(handle, 0x03);
+      }
+      // wait more than 4.1 ms after the first try, 100 us after the others
+      return state == _LCD_INIT_FUNCTIONSET_1 ? 4500 : 150;
+    case _LCD_INIT_INTERFACE:
+      if (_LCD_8BIT(handle)) {
+        return 0;
+      }
+      // finally, set to 4-bit interface
+      _lcd_write_4_bits(handle, 0x02);
+      return 150;
+    case _LCD_INIT_CONFIGURE:
+      // set # lines, font size, etc., turn the display on, set the entry
+      // mode and clear the display
+      _lcd_send_command(handle, LCD_FUNCTIONSET | handle->_displayfunction);
+      _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+      _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+      _lcd_send_command(handle, LCD_CLEARDISPLAY);
+      // 1.52 ms according to the datasheet, slow clones take longer
+      return 3000;
+    case _LCD_INIT_CLEARING:
+      // the clear has finished, the display is ready
+      return 0;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief Alarm callback running the initialization started by lcd_init_async().
+ *
+ * @param id Alarm ID (unused).
+ * @param user_data Pointer to the LCD handle.
+ * @return int64_t 0 when done, otherwise the time from now to the next step.
+ */
+int64_t _lcd_init_alarm(alarm_id_t id, void *user_data) {
+  (void)id;
+  LCD_Handle *handle = (LCD_Handle *)user_data;
+  if (lcd_init_poll(handle)) {
+    // the ID may be given to another alarm once this one is done
+    handle->_init_alarm = 0;
+    return 0;
+  }
+  const int64_t delay = (int64_t)(handle->_init_deadline - time_us_64());
+  return delay > 0 ? delay : 1;
+}
+
+/**
+ * @brief Configures the LCD display settings.
+ *
+ * This function sets the display parameters including the number of lines and character
+ * size. They are sent to the LCD by the initialization sequence, see _lcd_init_step().
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cols Number of columns of the LCD display.
+ * @param rows Number of rows of the LCD display.
+ * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
+ */
+void _lcd_setup(LCD_Handle *handle, uint8_t cols, uint8_t rows,
+                uint8_t charsize) {
+  if (rows > 1) {
+    handle->_displayfunction |= LCD_2LINE;
+  }
+  handle->_numlines = rows;
+
+  handle->_row_offsets[0] = 0x00;
+  handle->_row_offsets[1] = 0x40;
+  handle->_row_offsets[2] = 0x00 + cols;
+  handle->_row_offsets[3] = 0x40 + cols;
+
+  // for some 1 line displays you can select a 10 pixel high font
+  if ((charsize != LCD_5x8DOTS) && (rows == 1)) {
+    handle->_displayfunction |= LCD_5x10DOTS;
+  }
+
+  // turn the display on with no cursor or blinking default
+  handle->_displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+
+  // Initialize to default text direction (for romance languages)
+  handle->_displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+
+  // nothing was sent yet, so no setting can match
+  handle->_sent_displaycontrol = 0xFF;
+  handle->_sent_displaymode = 0xFF;
+}
+
+/**
+ * @brief Checks the arguments of lcd_init_*() against the fixed wiring.
+ *
+ * This function compares the bus width, the use of the RW pin and the pins with
+ * the LCD_CONFIG_* options that are fixed at compile time.
+ *
+ * @param rs GPIO pin number for the RS (Register Select) pin.
+ * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
+ * @param enable GPIO pin number for the Enable pin.
+ * @param data_pins GPIO pin numbers of the data lines (D4-D7 first in 4-bit mode).
+ * @param eightbitmode Boolean flag to specify if 8-bit mode is used.
+ * @return true if the arguments match the compile-time configuration.
+ */
+bool _lcd_config_matches(uint8_t rs, uint8_t rw, uint8_t enable,
+                         const uint8_t data_pins[8], bool eightbitmode) {
+#if LCD_CONFIG_BUS_WIDTH
+  if (eightbitmode != (LCD_CONFIG_BUS_WIDTH == 8)) {
+    return false;
+  }
+#else
+  (void)eightbitmode;
+#endif
+#if LCD_CONFIG_HAS_RW >= 0
+  if ((rw != 255) != (LCD_CONFIG_HAS_RW != 0)) {
+    return false;
+  }
+#endif
+#if LCD_CONFIG_PINS
+  static const uint8_t config_pins[] = {
+      _LCD_PIN_DATA0, _LCD_PIN_DATA1, _LCD_PIN_DATA2, _LCD_PIN_DATA3,
+#if LCD_CONFIG_BUS_WIDTH == 8
+      _LCD_PIN_DATA4, _LCD_PIN_DATA5, _LCD_PIN_DATA6, _LCD_PIN_DATA7,
+#endif
+  };
+  if (rs != LCD_CONFIG_PIN_RS || rw != _LCD_PIN_RW ||
+      enable != LCD_CONFIG_PIN_EN ||
+      memcmp(data_pins, config_pins, sizeof(config_pins)) != 0) {
+    return false;
+  }
+#else
+  (void)rs;
+  (void)rw;
+  (void)enable;
+  (void)data_pins;
+#endif
+  return true;
+}
+
+/**
+ * @brief Initializes the GPIO pins used for the LCD interface.
+ *
+ * This function sets the direction and initial state of the GPIO pins
+ * associated with the LCD data and control signals.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_init_pins(LCD_Handle *handle) {
+  gpio_init_mask(_LCD_DATA_PINS_MASK(handle));
+  gpio_set_dir_out_masked(_LCD_DATA_PINS_MASK(handle));
+  gpio_put_masked(_LCD_DATA_PINS_MASK(handle), 0);
+
+  gpio_init(_LCD_RS_PIN(handle));
+  gpio_set_dir(_LCD_RS_PIN(handle), GPIO_OUT);
+  gpio_put(_LCD_RS_PIN(handle), 0);
+
+  gpio_init(_LCD_EN_PIN(handle));
+  gpio_set_dir(_LCD_EN_PIN(handle), GPIO_OUT);
+  gpio_put(_LCD_EN_PIN(handle), 0);
+
+  if (_LCD_HAS_RW(handle)) {
+    gpio_init(_LCD_RW_PIN(handle));
+    gpio_set_dir(_LCD_RW_PIN(handle), GPIO_OUT);
+    gpio_put(_LCD_RW_PIN(handle), 0);
+  }
+}
+
+/**
+ * @brief Deinitializes the GPIO pins used for the LCD interface.
+ *
+ * This function resets the GPIO pins to their default state, effectively
+ * releasing them from their LCD-specific configuration.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_deinit_pins(LCD_Handle *handle) {
+  gpio_set_function_masked(_LCD_DATA_PINS_MASK(handle), GPIO_FUNC_NULL);
+  gpio_set_function(_LCD_RS_PIN(handle), GPIO_FUNC_NULL);
+  gpio_set_function(_LCD_EN_PIN(handle), GPIO_FUNC_NULL);
+  if (_LCD_HAS_RW(handle)) {
+    gpio_set_function(_LCD_RW_PIN(handle), GPIO_FUNC_NULL);
+  }
+}
+
+/**
+ * @brief Sends a command to the LCD.
+ *
+ * This function sends a command byte to the LCD. It waits for the LCD to be
+ * ready if the RW pin is used, sets the RS pin to command mode, and sends the
+ * command in either 8-bit or 4-bit mode depending on the LCD configuration.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param command Command byte to be sent to the LCD.
+ */
+void _LCD_RAM_FUNC(_lcd_send_command)(LCD_Handle *handle, uint8_t command) {
+  handle->_bus_depth++;
+  _LCD_STATS_BUS_BEGIN(handle);
+  _lcd_wait_ready(handle);
+  gpio_put(_LCD_RS_PIN(handle), 0);
+  if (_LCD_8BIT(handle)) {
+    _lcd_write_8_bits(handle, command);
+  } else {
+    _lcd_write_4_bits(handle, command >> 4);
+    _lcd_write_4_bits(handle, command);
+  }
+  _lcd_track_command(handle, command);
+  if (handle->_record != NULL) {
+    _lcd_record_transfer(handle, 0, command);
+  }
+  _LCD_STATS_ADD(handle, commands, 1);
+  _LCD_STATS_BUS_END(handle);
+  handle->_bus_depth--;
+}
+
+/**
+ * @brief Sends data to the LCD.
+ *
+ * This function sends a data byte to the LCD. It sends a pending entry mode
+ * change first, waits for the LCD to be ready if the RW pin is used, sets the
+ * RS pin to data mode, and sends the data in either 8-bit or 4-bit mode
+ * depending on the LCD configuration.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param data Data byte to be sent to the LCD.
+ */
+void _LCD_RAM_FUNC(_lcd_send_data)(LCD_Handle *handle, uint8_t data) {
+  // the entry mode and the address must still hold when the byte is sent
+  handle->_bus_depth++;
+  if (handle->_sent_displaymode != handle->_displaymode) {
+    // entry mode changes are only sent when they matter
+    _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+  }
+  _LCD_STATS_BUS_BEGIN(handle);
+  _lcd_wait_ready(handle);
+  gpio_put(_LCD_RS_PIN(handle), 1);
+  if (_LCD_8BIT(handle)) {
+    _lcd_write_8_bits(handle, data);
+  } else {
+    _lcd_write_4_bits(handle, data >> 4);
+    _lcd_write_4_bits(handle, data);
+  }
+  _lcd_track_data(handle, data);
+  if (handle->_record != NULL) {
+    _lcd_record_transfer(handle, LCD_STREAM_RS, data);
+  }
+  _LCD_STATS_ADD(handle, data_bytes, 1);
+  _LCD_STATS_BUS_END(handle);
+  handle->_bus_depth--;
+}
+
+/**
+ * @brief Reads the visible part of the DDRAM, row by row.
+ *
+ * This function visits the rows in DDRAM order and only sets the address when
+ * a row doesn't start where the address counter stopped, so the rows of a 20x4
+ * or a 40x2 display are read in a single auto-incrementing stream. The address
+ * counter must increment (see _lcd_begin_sequential()).
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param buffer Buffer for _cols * _numlines characters (row-major).
+ */
+void _lcd_read_ddram(LCD_Handle *handle, uint8_t *buffer) {
+  static const uint8_t row_order[4] = {0, 2, 1, 3};
+  for (int i = 0; i < 4; i++) {
+    const uint8_t row = row_order[i];
+    if (row >= handle->_numlines) {
+      continue;
+    }
+    const uint8_t start = handle->_row_offsets[row];
+    if (handle->_cgram_selected || handle->_address != start) {
+      _lcd_send_command(handle, LCD_SETDDRAMADDR | start);
+    }
+    uint8_t *line = buffer + row * handle->_cols;
+    for (uint8_t col = 0; col < handle->_cols; col++) {
+      line[col] = _lcd_read_data(handle);
+    }
+  }
+}
+
+/**
+ * @brief Reads the whole CGRAM (8 custom characters, 8 rows each).
+ *
+ * The address counter must increment (see _lcd_begin_sequential()).
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param buffer Buffer for 64 bytes, one character row (5 bits) per byte.
+ */
+void _lcd_read_cgram(LCD_Handle *handle, uint8_t *buffer) {
+  _lcd_send_command(handle, LCD_SETCGRAMADDR);
+  for (uint8_t i = 0; i < 64; i++) {
+    buffer[i] = _lcd_read_data(handle) & 0x1F;
+  }
+}
+
+/**
+ * @brief Checks that the controller uses the configured interface.
+ *
+ * This function sets the address counter to 0x27 and reads one data byte. The
+ * counter has to move on to 0x40 in 2-line mode or to 0x28 in 1-line mode,
+ * which only happens if the controller uses the expected interface width and
+ * number of lines and the nibbles are in sync. The address counter must
+ * increment (see _lcd_begin_sequential()).
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return true if the controller answered as expected.
+ */
+bool _lcd_probe(LCD_Handle *handle) {
+  _lcd_send_command(handle, LCD_SETDDRAMADDR | 0x27);
+  _lcd_read_data(handle);
+  _lcd_wait_ready(handle);
+  return (_lcd_read_command(handle) & 0x7F) == handle->_address;
+}
+
+/**
+ * @brief Initializes the controller again and restores the state of the LCD.
+ *
+ * This function runs the initialization sequence, which also sends the current
+ * display control, uploads the known custom characters and writes the frame
+ * buffer. It blocks for the duration of the sequence.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param displaymode Entry mode to restore.
+ * @param address Address counter to restore.
+ * @param cgram_selected true if the address counter pointed into CGRAM.
+ */
+void _lcd_restore(LCD_Handle *handle, uint8_t displaymode, uint8_t address,
+                  bool cgram_selected) {
+  handle->_init_state = _LCD_INIT_FUNCTIONSET_1;
+  handle->_init_deadline = 0;
+  _lcd_finish_init(handle);
+
+  _lcd_begin_sequential(handle);
+  for (uint8_t num = 0; num < 8; num++) {
+    if (!(handle->_cgram_valid & (1 << num))) {
+      continue;
+    }
+    if (!handle->_cgram_selected || handle->_address != num << 3) {
+      _lcd_send_command(handle, LCD_SETCGRAMADDR | (num << 3));
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+      _lcd_send_data(handle, handle->_cgram[(num << 3) + i]);
+    }
+  }
+  _lcd_flush_frame(handle, true);
+  _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+}
+
+/**
+ * @brief Writes the cells of the frame buffer that differ from the shadow copy.
+ *
+ * This function writes runs of changed cells with the address counter
+ * auto-incrementing. Right-to-left entry and autoscroll would break that, so the
+ * entry mode is switched to left-to-right for the duration of the flush. Cells
+ * with attributes are compared in the form they should be shown in, so all
+ * blinking cells toggle in the same pass, in the same runs as the other changes.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param attributes false to leave cells with attributes as they are.
+ */
+void _LCD_RAM_FUNC(_lcd_flush_frame)(LCD_Handle *handle, bool attributes) {
+  if (handle->_init_state != _LCD_INIT_READY) {
+    return;
+  }
+  const size_t cells = (size_t)handle->_cols * handle->_numlines;
+  if (handle->_attribute_cells == 0) {
+    size_t first = 0;
+    while (first < cells && handle->_frame[first] == handle->_shadow[first]) {
+      first++;
+    }
+    if (first == cells) {
+      return;
+    }
+  }
+  const bool hidden = attributes && _lcd_blink_hidden(handle);
+
+  const uint8_t address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  const uint8_t displaymode = _lcd_begin_sequential(handle);
+  // the shadow gets the codes shown, the frame keeps the characters
+  handle->_redrawing = true;
+  for (uint8_t row = 0; row < handle->_numlines; row++) {
+    const size_t offset = (size_t)row * handle->_cols;
+    const uint8_t *frame = handle->_frame + offset;
+    const uint8_t *shadow = handle->_shadow + offset;
+    for (uint8_t col = 0; col < handle->_cols; col++) {
+      uint8_t code = frame[col];
+      if (handle->_attributes[offset + col] != 0) {
+        if (!attributes) {
+          continue;
+        }
+        code = _lcd_apply_attributes(handle, offset + col, hidden);
+      }
+      if (code == shadow[col]) {
+        continue;
+      }
+      const uint8_t target = handle->_row_offsets[row] + col;
+      if (handle->_cgram_selected || handle->_address != target) {
+        _lcd_send_command(handle, LCD_SETDDRAMADDR | target);
+      }
+      _lcd_send_data(handle, code);
+    }
+  }
+  handle->_redrawing = false;
+  _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+}
+
+/**
+ * @brief Decides if overwriting the shown characters is quicker than a clear.
+ *
+ * This function estimates both ways from the shadow copy and the transport: a
+ * transfer takes about one instruction time plus the bus transfer (~50 us) when
+ * the busy flag is polled and the fixed delay of the write routines otherwise.
+ * Overwriting is only possible if the display isn't shifted and nothing was
+ * written to the DDRAM outside the visible area, which only the clear
+ * instruction would blank. A recorded stream must clear whatever is on the
+ * display when it is replayed, so it always gets the clear instruction.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return true if the characters should be overwritten with spaces.
+ */
+bool _lcd_clear_by_writing(LCD_Handle *handle) {
+  if (handle->_init_state != _LCD_INIT_READY || handle->_shift != 0 ||
+      handle->_offscreen_dirty || handle->_record != NULL) {
+    return false;
+  }
+  const uint32_t transfer_us =
+      _LCD_HAS_RW(handle) ? 50 : (_LCD_8BIT(handle) ? 100 : 200);
+  // moving the cursor home and switching the entry mode if needed
+  uint32_t transfers =
+      handle->_sent_displaymode == LCD_ENTRYLEFT ? 1 : 2;
+  for (uint8_t row = 0; row < handle->_numlines; row++) {
+    const uint8_t *shadow = handle->_shadow + row * handle->_cols;
+    bool in_run = false;
+    for (uint8_t col = 0; col < handle->_cols; col++) {
+      if (shadow[col] == ' ') {
+        in_run = false;
+        continue;
+      }
+      // a run of characters needs the address set once
+      transfers += in_run ? 1 : 2;
+      in_run = true;
+    }
+  }
+  return transfers * transfer_us < _LCD_CLEAR_US + transfer_us;
+}
+
+/**
+ * @brief Sends the display control settings if they changed.
+ *
+ * Nothing is sent while a transaction is open or before the display is ready; the
+ * initialization sequence and lcd_commit() send the settings then. While a stream
+ * is recorded, the settings are sent even if the controller already holds them,
+ * as the stream may be replayed in any state.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_sync_display_control(LCD_Handle *handle) {
+  if (handle->_transaction_depth == 0 &&
+      handle->_init_state == _LCD_INIT_READY &&
+      (handle->_sent_displaycontrol != handle->_displaycontrol ||
+       handle->_record != NULL)) {
+    _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+    // animations pause while the display is off
+    _lcd_start_animations(handle);
+  }
+}
+
+/**
+ * @brief Waits for an instruction with a long execution time.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param us Execution time in microseconds.
+ */
+void _lcd_wait_instruction(LCD_Handle *handle, uint32_t us) {
+  if (handle->_record != NULL) {
+    // rounded up, longer waits are split into annotations of 127 units
+    uint32_t units =
+        (us + LCD_STREAM_WAIT_UNIT_US - 1) / LCD_STREAM_WAIT_UNIT_US;
+    while (units > 0) {
+      const uint8_t chunk = units > 127 ? 127 : units;
+      _lcd_record_byte(handle, LCD_STREAM_WAIT | chunk);
+      units -= chunk;
+    }
+  }
+  _lcd_delay_us(handle, us);
+}
+
+/**
+ * @brief Puts the transfers of a recorded stream on the bus.
+ *
+ * The nibbles or bytes go to the data lines as they were encoded, with a busy
+ * flag poll (or the fixed delay without the RW pin) between transfers. Nothing
+ * is tracked here, see _lcd_replay_track().
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param stream Recorded stream for the bus width of the display.
+ * @param length Length of the stream in bytes.
+ * @return size_t Length of the part of the stream that was sent, short of
+ *         `length` if the stream ends in the middle of a transfer.
+ */
+size_t _LCD_RAM_FUNC(_lcd_replay_transfers)(LCD_Handle *handle,
+                                            const uint8_t *stream,
+                                            size_t length) {
+  _LCD_STATS_BUS_BEGIN(handle);
+  size_t i = 1;
+  while (i < length) {
+    const uint8_t flags = stream[i];
+    if (flags & LCD_STREAM_WAIT) {
+      const uint8_t units = flags & ~LCD_STREAM_WAIT;
+      _lcd_delay_us(handle, units * LCD_STREAM_WAIT_UNIT_US);
+      i++;
+      continue;
+    }
+    // a transfer takes two bytes in both encodings
+    if (i + 1 >= length) {
+      break;
+    }
+    _lcd_wait_ready(handle);
+    gpio_put(_LCD_RS_PIN(handle), flags & LCD_STREAM_RS);
+    if (_LCD_8BIT(handle)) {
+      _lcd_write_8_bits(handle, stream[i + 1]);
+    } else {
+      _lcd_write_4_bits(handle, flags & 0x0F);
+      _lcd_write_4_bits(handle, stream[i + 1] & 0x0F);
+    }
+    i += 2;
+  }
+  _LCD_STATS_BUS_END(handle);
+  return i;
+}
+
+/**
+ * @brief Updates the shadow state for a stream sent by _lcd_replay_transfers().
+ *
+ * The transfers are tracked in the order they were sent, which leaves the same
+ * state as sending them one by one. A stream replayed during a recording is
+ * appended to it as is.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param stream Recorded stream for the bus width of the display.
+ * @param length Length of the part of the stream that was sent.
+ */
+void _lcd_replay_track(LCD_Handle *handle, const uint8_t *stream,
+                       size_t length) {
+  for (size_t i = 1; i < length; i++) {
+    const uint8_t flags = stream[i];
+    if (handle->_record != NULL) {
+      _lcd_record_byte(handle, flags);
+    }
+    if (flags & LCD_STREAM_WAIT) {
+      continue;
+    }
+    i++;
+    if (handle->_record != NULL) {
+      _lcd_record_byte(handle, stream[i]);
+    }
+    // 4-bit streams hold one nibble per byte, 8-bit streams a flag byte
+    // followed by the value
+    const uint8_t value = _LCD_8BIT(handle)
+                              ? stream[i]
+                              : (uint8_t)(flags << 4) | (stream[i] & 0x0F);
+    if (flags & LCD_STREAM_RS) {
+      _lcd_track_data(handle, value);
+      _LCD_STATS_ADD(handle, data_bytes, 1);
+      continue;
+    }
+    _lcd_track_command(handle, value);
+    _LCD_STATS_ADD(handle, commands, 1);
+    if (value == LCD_CLEARDISPLAY) {
+      // like lcd_clear(), drop what was buffered
+      memset(handle->_frame, ' ', (size_t)handle->_cols * handle->_numlines);
+      memset(handle->_attributes, 0,
+             (size_t)handle->_cols * handle->_numlines);
+      handle->_attribute_cells = 0;
+      _lcd_touch_windows(handle);
+    } else if ((value & 0xF8) == LCD_DISPLAYCONTROL) {
+      handle->_displaycontrol = handle->_sent_displaycontrol;
+    } else if ((value & 0xFC) == LCD_ENTRYMODESET) {
+      handle->_displaymode = handle->_sent_displaymode;
+    }
+  }
+}
+
+/**
+ * @brief Appends a transfer to the stream being recorded.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param flags LCD_STREAM_RS for data, 0 for an instruction.
+ * @param value Byte sent to the LCD.
+ */
+void _LCD_RAM_FUNC(_lcd_record_transfer)(LCD_Handle *handle, uint8_t flags,
+                                         uint8_t value) {
+  if (_LCD_8BIT(handle)) {
+    _lcd_record_byte(handle, flags);
+    _lcd_record_byte(handle, value);
+  } else {
+    _lcd_record_byte(handle, flags | (value >> 4));
+    _lcd_record_byte(handle, flags | (value & 0x0F));
+  }
+}
+
+/**
+ * @brief Appends a byte to the stream being recorded.
+ *
+ * The length keeps counting when the buffer is full, so lcd_record_end() can
+ * tell that the stream was cut off.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param byte Byte to append.
+ */
+void _LCD_RAM_FUNC(_lcd_record_byte)(LCD_Handle *handle, uint8_t byte) {
+  if (handle->_record_length < handle->_record_size) {
+    handle->_record[handle->_record_length] = byte;
+  }
+  handle->_record_length++;
+}
+
+/**
+ * @brief Formats a number into a field and writes the changed characters.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value Number to display, scaled by 10^decimals.
+ * @param decimals Number of digits after the decimal point (0-9).
+ * @param width Field width in characters.
+ * @param flags Combination of LCD_NUM_LEFT, LCD_NUM_ZEROS and LCD_NUM_PLUS.
+ * @param col Column of the first character of the field.
+ * @param row Row of the field.
+ */
+void _lcd_write_number(LCD_Handle *handle, int32_t value, uint8_t decimals,
+                       uint8_t width, uint8_t flags, uint8_t col, uint8_t row) {
+  if (col >= handle->_cols || row >= handle->_numlines || width == 0) {
+    return;
+  }
+  if (width > handle->_cols - col) {
+    width = handle->_cols - col;
+  }
+  uint8_t text[40];
+  _lcd_format_number(text, width, value, decimals, flags);
+  _lcd_write_cells(handle, text, width, col, row);
+}
+
+/**
+ * @brief Formats a number right- or left-aligned into a field.
+ *
+ * The digits are found by subtracting powers of ten, which needs no division
+ * (the M0+ cores have no divide instruction). Numbers that don't fit fill the
+ * field with '#'.
+ *
+ * @param text Receives `width` characters, not null-terminated.
+ * @param width Field width in characters (1-40).
+ * @param value Number to format, scaled by 10^decimals.
+ * @param decimals Number of digits after the decimal point (0-9).
+ * @param flags Combination of LCD_NUM_LEFT, LCD_NUM_ZEROS and LCD_NUM_PLUS.
+ * @return uint8_t Number of characters of the number without padding, 0 if it
+ *         didn't fit.
+ */
+uint8_t _lcd_format_number(uint8_t *text, uint8_t width, int32_t value,
+                           uint8_t decimals, uint8_t flags) {
+  static const uint32_t powers[] = {1000000000, 100000000, 10000000, 1000000,
+                                    100000,     10000,     1000,     100,
+                                    10,         1};
+  uint32_t magnitude = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+  uint8_t digits[10];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < 10; i++) {
+    uint8_t digit = 0;
+    while (magnitude >= powers[i]) {
+      magnitude -= powers[i];
+      digit++;
+    }
+    // skip leading zeros, but keep one before the decimal point
+    if (count > 0 || digit > 0 || i >= 9 - decimals) {
+      digits[count++] = '0' + digit;
+    }
+  }
+  const uint8_t sign =
+      value < 0 ? '-' : ((flags & LCD_NUM_PLUS) ? '+' : '\0');
+  const uint8_t length = (sign ? 1 : 0) + count + (decimals ? 1 : 0);
+  if (length > width) {
+    memset(text, '#', width);
+    return 0;
+  }
+
+  uint8_t position = 0;
+  uint8_t padding = width - length;
+  if (!(flags & LCD_NUM_LEFT) && !(flags & LCD_NUM_ZEROS)) {
+    memset(text, ' ', padding);
+    position = padding;
+  }
+  if (sign) {
+    text[position++] = sign;
+  }
+  if (!(flags & LCD_NUM_LEFT) && (flags & LCD_NUM_ZEROS)) {
+    memset(text + position, '0', padding);
+    position += padding;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    if (decimals && i == count - decimals) {
+      text[position++] = '.';
+    }
+    text[position++] = digits[i];
+  }
+  memset(text + position, ' ', width - position);
+  return length;
+}
+
+/**
+ * @brief Writes the cells of a field that differ from the display.
+ *
+ * The cells are also put into the frame buffer. Before the display is ready
+ * they are only put there and shown by the next flush.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cells Character codes of the field.
+ * @param count Number of cells, must fit into the row.
+ * @param col Column of the first cell.
+ * @param row Row of the field.
+ */
+void _lcd_write_cells(LCD_Handle *handle, const uint8_t *cells, uint8_t count,
+                      uint8_t col, uint8_t row) {
+  const size_t offset = (size_t)row * handle->_cols + col;
+  for (uint8_t i = 0; i < count; i++) {
+    _lcd_put_cell(handle, offset + i, cells[i], false);
+  }
+  _lcd_show_cells(handle, count, col, row);
+}
+
+/**
+ * @brief Writes the cells of a run of the frame buffer that differ from the
+ * display.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param count Number of cells, they must fit the row.
+ * @param col Column of the first cell.
+ * @param row Row of the cells.
+ */
+void _lcd_show_cells(LCD_Handle *handle, uint8_t count, uint8_t col,
+                     uint8_t row) {
+  const size_t offset = (size_t)row * handle->_cols + col;
+  const uint8_t *shadow = handle->_shadow + offset;
+  if (handle->_init_state != _LCD_INIT_READY) {
+    return;
+  }
+  const bool hidden = _lcd_blink_hidden(handle);
+  uint8_t first = 0;
+  while (first < count &&
+         _lcd_apply_attributes(handle, offset + first, hidden) ==
+             shadow[first]) {
+    first++;
+  }
+  if (first == count) {
+    return;
+  }
+  const uint8_t address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  const uint8_t displaymode = _lcd_begin_sequential(handle);
+  handle->_redrawing = true;
+  for (uint8_t i = first; i < count; i++) {
+    const uint8_t code = _lcd_apply_attributes(handle, offset + i, hidden);
+    if (code == shadow[i]) {
+      continue;
+    }
+    const uint8_t target = handle->_row_offsets[row] + col + i;
+    if (handle->_cgram_selected || handle->_address != target) {
+      _lcd_send_command(handle, LCD_SETDDRAMADDR | target);
+    }
+    _lcd_send_data(handle, code);
+  }
+  handle->_redrawing = false;
+  _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+}
+
+/**
+ * @brief Checks if blinking cells are hidden now.
+ *
+ * All handles share the phase, which follows the system timer.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return true in the second half of the blink period if any cell has
+ *         attributes.
+ */
+bool _lcd_blink_hidden(LCD_Handle *handle) {
+  return handle->_attribute_cells != 0 &&
+         (time_us_64() / (LCD_BLINK_PERIOD_MS * 500ull)) % 2 == 1;
+}
+
+/**
+ * @brief Finds the character code to show in a cell of the frame buffer.
+ *
+ * A planned glyph shows the slot given to it by the last plan, or its ASCII
+ * replacement if it got none. The inverted glyph of an ASCII character is made
+ * from the ticker font and kept in the glyph cache under a code point of the
+ * private use area, so it is shared by all cells that show the same character.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cell Index of the cell (row-major).
+ * @param hidden true if blinking cells are hidden now.
+ * @return uint8_t Character code to write to the display.
+ */
+uint8_t _lcd_apply_attributes(LCD_Handle *handle, size_t cell, bool hidden) {
+  const uint8_t attributes = handle->_attributes[cell];
+  uint8_t code = handle->_frame[cell];
+  if (attributes & _LCD_ATTR_GLYPH) {
+    // the plan may be older than the cell, so the glyph is looked up in the
+    // slots until the next flush plans it
+    const uint16_t codepoint = handle->_plan_codepoints[code];
+    uint8_t slot = handle->_plan_codes[code];
+    if (slot == 0xFF || handle->_glyph_codepoints[slot] != codepoint) {
+      slot = 0;
+      while (slot < 8 && ((handle->_glyph_reserved & (1 << slot)) ||
+                          handle->_glyph_codepoints[slot] != codepoint)) {
+        slot++;
+      }
+    }
+    code = slot < 8 ? slot : handle->_plan_fallbacks[code];
+  }
+  if ((attributes & LCD_ATTR_BLINK) && hidden) {
+    code = ' ';
+  }
+  // the A00 ROM has a yen sign and an arrow in place of '\' and '~'
+  if (!(attributes & LCD_ATTR_INVERSE) || code < 0x20 || code > 0x7E ||
+      (handle->_charset == LCD_CHARSET_A00 && (code == '\\' || code == '~'))) {
+    return code;
+  }
+  _LCD_Glyph glyph = {.codepoint = 0xE000 + code};
+  const uint8_t *columns = _lcd_font[code - 0x20];
+  for (uint8_t row = 0; row < 8; row++) {
+    uint8_t bits = 0;
+    for (uint8_t column = 0; column < 5; column++) {
+      bits = (bits << 1) | ((columns[column] >> row) & 1);
+    }
+    glyph.rows[row] = ~bits & 0x1F;
+  }
+  const int slot = _lcd_glyph_slot(handle, &glyph);
+  return slot >= 0 ? slot : code;
+}
+
+/**
+ * @brief Puts a character code or a planned glyph into the frame buffer.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cell Index of the cell (row-major).
+ * @param code Character code, or index into _plan_codepoints.
+ * @param planned true if code is an index into _plan_codepoints.
+ */
+void _lcd_put_cell(LCD_Handle *handle, size_t cell, uint8_t code,
+                   bool planned) {
+  uint8_t *attributes = handle->_attributes + cell;
+  handle->_frame[cell] = code;
+  if (planned) {
+    handle->_attribute_cells += *attributes == 0;
+    *attributes |= _LCD_ATTR_GLYPH;
+    // the glyph may have lost its slot while it was hidden
+    if (handle->_plan_codes[code] == 0xFF) {
+      handle->_plan_valid = false;
+    }
+    return;
+  }
+  if (*attributes & _LCD_ATTR_GLYPH) {
+    *attributes &= ~_LCD_ATTR_GLYPH;
+    handle->_attribute_cells -= *attributes == 0;
+  }
+  // the plan may have given the slot of this custom character to a glyph
+  if (code < 16 && !(handle->_glyph_reserved & (1 << (code & 0x7)))) {
+    handle->_plan_valid = false;
+  }
+}
+
+/**
+ * @brief Adds a character that needs a CGRAM glyph to the planned glyphs.
+ *
+ * Characters the ROM holds, characters without a glyph and raw text aren't
+ * planned. When the table is full, entries no cell refers to anymore are
+ * dropped.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param codepoint Value returned by _lcd_decode().
+ * @return int Index into _plan_codepoints, or -1 if the character isn't
+ *         planned.
+ */
+int _lcd_plan_glyph(LCD_Handle *handle, uint32_t codepoint) {
+  uint8_t codes[2];
+  if (handle->_charset == LCD_CHARSET_RAW ||
+      _lcd_lookup_rom(handle, codepoint, codes) != 0 ||
+      _lcd_find_glyph(codepoint) == NULL) {
+    return -1;
+  }
+  int index = -1;
+  for (uint8_t i = 0; i < LCD_MAX_PLANNED_GLYPHS; i++) {
+    if (handle->_plan_codepoints[i] == codepoint) {
+      if (handle->_plan_codes[i] == 0xFF) {
+        // a slot may have become free since
+        handle->_plan_valid = false;
+      }
+      return i;
+    }
+    if (index < 0 && handle->_plan_codepoints[i] == 0) {
+      index = i;
+    }
+  }
+  if (index < 0) {
+    uint32_t used = _lcd_hidden_glyphs(handle);
+    const size_t cells = (size_t)handle->_cols * handle->_numlines;
+    for (size_t i = 0; i < cells; i++) {
+      if (handle->_attributes[i] & _LCD_ATTR_GLYPH) {
+        used |= 1ul << handle->_frame[i];
+      }
+    }
+    for (uint8_t i = 0; i < LCD_MAX_PLANNED_GLYPHS; i++) {
+      if (!(used & (1ul << i))) {
+        handle->_plan_codepoints[i] = 0;
+        if (index < 0) {
+          index = i;
+        }
+      }
+    }
+    if (index < 0) {
+      return -1;
+    }
+  }
+  _lcd_transliterate(codepoint, codes);
+  handle->_plan_codepoints[index] = codepoint;
+  handle->_plan_fallbacks[index] = codes[0];
+  handle->_plan_codes[index] = 0xFF;
+  handle->_plan_valid = false;
+  return index;
+}
+
+/**
+ * @brief Gives the planned glyphs of the frame buffer the free CGRAM slots.
+ *
+ * Glyphs that are already in CGRAM keep their slot, the others get the slots
+ * that aren't reserved and aren't shown by other cells, those used by the most
+ * cells first. The rest show their ASCII replacement. All new glyphs are
+ * uploaded in one burst. The plan is kept until characters without a slot are
+ * drawn again, new characters are planned or the slots change, so redrawing
+ * the same screen needs no planning.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_plan_screen(LCD_Handle *handle) {
+  if (handle->_init_state != _LCD_INIT_READY) {
+    return;
+  }
+  bool valid = handle->_plan_valid &&
+               handle->_plan_reserved == handle->_glyph_reserved;
+  for (uint8_t i = 0; i < LCD_MAX_PLANNED_GLYPHS && valid; i++) {
+    const uint8_t slot = handle->_plan_codes[i];
+    valid = handle->_plan_codepoints[i] == 0 || slot == 0xFF ||
+            handle->_glyph_codepoints[slot] == handle->_plan_codepoints[i];
+  }
+  if (valid) {
+    return;
+  }
+
+  uint8_t uses[LCD_MAX_PLANNED_GLYPHS] = {0};
+  // characters hidden by windows or sprites stay planned
+  const uint32_t kept = _lcd_hidden_glyphs(handle);
+  uint8_t held = handle->_glyph_reserved;
+  const size_t cells = (size_t)handle->_cols * handle->_numlines;
+  for (size_t i = 0; i < cells; i++) {
+    const uint8_t code = handle->_frame[i];
+    if (handle->_attributes[i] & _LCD_ATTR_GLYPH) {
+      uses[code] += uses[code] < 0xFF;
+      continue;
+    }
+    if (code < 16) {
+      held |= 1 << (code & 0x7);
+    }
+    // other cells showing a custom character are overwritten by this flush,
+    // cells with attributes show the glyphs they were drawn with
+    if (handle->_attributes[i] != 0 && handle->_shadow[i] < 16) {
+      held |= 1 << (handle->_shadow[i] & 0x7);
+    }
+  }
+  // glyphs already in CGRAM stay where they are
+  for (uint8_t i = 0; i < LCD_MAX_PLANNED_GLYPHS; i++) {
+    handle->_plan_codes[i] = 0xFF;
+    if (uses[i] == 0) {
+      if (!(kept & (1ul << i))) {
+        handle->_plan_codepoints[i] = 0;
+      }
+      continue;
+    }
+    for (uint8_t slot = 0; slot < 8; slot++) {
+      if (!(handle->_glyph_reserved & (1 << slot)) &&
+          handle->_glyph_codepoints[slot] == handle->_plan_codepoints[i]) {
+        handle->_plan_codes[i] = slot;
+        held |= 1 << slot;
+        uses[i] = 0;
+        break;
+      }
+    }
+  }
+  uint8_t rows[64];
+  uint8_t slots = 0;
+  while (held != 0xFF) {
+    uint8_t best = 0;
+    for (uint8_t i = 1; i < LCD_MAX_PLANNED_GLYPHS; i++) {
+      if (uses[i] > uses[best]) {
+        best = i;
+      }
+    }
+    if (uses[best] == 0) {
+      break;
+    }
+    uses[best] = 0;
+    uint8_t slot = handle->_glyph_next;
+    while (held & (1 << slot)) {
+      slot = (slot + 1) & 0x7;
+    }
+    const uint16_t codepoint = handle->_plan_codepoints[best];
+    memcpy(rows + (slot << 3), _lcd_find_glyph(codepoint)->rows, 8);
+    slots |= 1 << slot;
+    held |= 1 << slot;
+    handle->_plan_codes[best] = slot;
+    handle->_glyph_codepoints[slot] = codepoint;
+    handle->_glyph_next = (slot + 1) & 0x7;
+  }
+  _lcd_write_cgram(handle, slots, rows);
+  handle->_plan_valid = true;
+  handle->_plan_reserved = handle->_glyph_reserved;
+}
+
+/**
+ * @brief Puts a character code and attributes into a cell of a window.
+ *
+ * The cell is only marked for the compositor if it changes, so drawing the
+ * same content again costs nothing at the next flush.
+ *
+ * @param window Window to draw into.
+ * @param col Column in the window.
+ * @param row Row in the window.
+ * @param code Character code, or index into _plan_codepoints.
+ * @param attributes LCD_ATTR_* of the cell, with _LCD_ATTR_GLYPH if code is an
+ *                   index into _plan_codepoints.
+ */
+void _lcd_window_put(LCD_Window *window, uint8_t col, uint8_t row,
+                     uint8_t code, uint8_t attributes) {
+  const size_t size = (size_t)window->width * window->height;
+  uint8_t *cell = window->cells + (size_t)row * window->width + col;
+  if (cell[0] == code && cell[size] == attributes) {
+    return;
+  }
+  cell[0] = code;
+  cell[size] = attributes;
+  _lcd_touch_window(window, col, row, 1, 1);
+}
+
+/**
+ * @brief Marks a rectangle of a window for the compositor.
+ *
+ * @param window Window whose cells changed.
+ * @param col Column of the top left cell in the window.
+ * @param row Row of the top left cell in the window.
+ * @param width Width in cells, at least 1.
+ * @param height Height in cells, at least 1.
+ */
+void _lcd_touch_window(LCD_Window *window, uint8_t col, uint8_t row,
+                       uint8_t width, uint8_t height) {
+  const uint8_t right = col + width - 1;
+  const uint8_t bottom = row + height - 1;
+  if (window->dirty_left > window->dirty_right) {
+    window->dirty_left = col;
+    window->dirty_top = row;
+    window->dirty_right = right;
+    window->dirty_bottom = bottom;
+    return;
+  }
+  if (col < window->dirty_left) {
+    window->dirty_left = col;
+  }
+  if (row < window->dirty_top) {
+    window->dirty_top = row;
+  }
+  if (right > window->dirty_right) {
+    window->dirty_right = right;
+  }
+  if (bottom > window->dirty_bottom) {
+    window->dirty_bottom = bottom;
+  }
+}
+
+/**
+ * @brief Marks all open windows for the compositor.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_touch_windows(LCD_Handle *handle) {
+  for (LCD_Window *window = handle->_windows; window != NULL;
+       window = window->next) {
+    _lcd_touch_window(window, 0, 0, window->width, window->height);
+  }
+}
+
+/**
+ * @brief Composes the changed cells of the open windows into the frame buffer.
+ *
+ * Only the rectangles that changed since the last flush are looked at, every
+ * cell in them gets the content of the topmost window covering it.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_compose(LCD_Handle *handle) {
+  for (LCD_Window *window = handle->_windows; window != NULL;
+       window = window->next) {
+    if (window->dirty_left > window->dirty_right) {
+      continue;
+    }
+    for (uint8_t row = window->dirty_top; row <= window->dirty_bottom; row++) {
+      for (uint8_t col = window->dirty_left; col <= window->dirty_right;
+           col++) {
+        _lcd_compose_cell(handle, window->col + col, window->row + row);
+      }
+    }
+    window->dirty_left = 0xFF;
+    window->dirty_right = 0;
+  }
+}
+
+/**
+ * @brief Copies the topmost window covering a cell into the frame buffer.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param col Column on the display.
+ * @param row Row on the display.
+ */
+void _lcd_compose_cell(LCD_Handle *handle, uint8_t col, uint8_t row) {
+  const LCD_Window *window = handle->_windows;
+  while (window != NULL &&
+         (col < window->col || col >= window->col + window->width ||
+          row < window->row || row >= window->row + window->height)) {
+    window = window->next;
+  }
+  uint8_t code = ' ';
+  uint8_t attributes = 0;
+  if (window != NULL) {
+    const size_t size = (size_t)window->width * window->height;
+    const size_t index =
+        (size_t)(row - window->row) * window->width + col - window->col;
+    code = window->cells[index];
+    attributes = window->cells[size + index];
+  }
+  const size_t cell = (size_t)row * handle->_cols + col;
+  const bool planned = attributes & _LCD_ATTR_GLYPH;
+  _lcd_put_cell(handle, cell, code, planned);
+  uint8_t *current = handle->_attributes + cell;
+  handle->_attribute_cells += (attributes != 0) - (*current != 0);
+  *current = attributes;
+}
+
+/**
+ * @brief Collects the planned glyphs kept outside the frame buffer.
+ *
+ * These are the cells of open windows and the cells covered by sprites, they
+ * may show again without being drawn.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return uint32_t Bitmask of indices into _plan_codepoints.
+ */
+uint32_t _lcd_hidden_glyphs(LCD_Handle *handle) {
+  uint32_t used = 0;
+  for (uint8_t slot = 0; slot < 8; slot++) {
+    if (handle->_sprite_planned & (1 << slot)) {
+      used |= 1ul << handle->_sprite_backgrounds[slot];
+    }
+  }
+  for (const LCD_Window *window = handle->_windows; window != NULL;
+       window = window->next) {
+    const size_t size = (size_t)window->width * window->height;
+    for (size_t i = 0; i < size; i++) {
+      if (window->cells[size + i] & _LCD_ATTR_GLYPH) {
+        used |= 1ul << window->cells[i];
+      }
+    }
+  }
+  return used;
+}
+
+/**
+ * @brief Draws big characters and writes the cells that changed.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param text Characters to draw.
+ * @param length Number of characters.
+ * @param col Column of the top left corner.
+ * @param row Row of the top left corner.
+ */
+void _lcd_write_big(LCD_Handle *handle, const uint8_t *text, uint8_t length,
+                    uint8_t col, uint8_t row) {
+  const uint8_t height = handle->_big_height;
+  if (height == 0 || col >= handle->_cols ||
+      row + height > handle->_numlines) {
+    return;
+  }
+  const uint8_t width = handle->_cols - col;
+  // a space and the custom characters of the big font
+  uint8_t codes[_LCD_BIG_GLYPHS + 1] = {' '};
+  for (uint8_t i = 0; i < _LCD_BIG_GLYPHS; i++) {
+    codes[i + 1] = handle->_big_slot + i;
+  }
+  uint8_t cells[4][40];
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < length && count < width; i++) {
+    const uint8_t symbol = text[i];
+    if (symbol == '.' || symbol == ':') {
+      for (uint8_t r = 0; r < height; r++) {
+        cells[r][count] = ' ';
+      }
+      if (symbol == '.') {
+        cells[height - 1][count] = '.';
+      } else {
+        cells[height / 2 - 1][count] = codes[_LCD_BIG_DOT];
+        cells[height / 2][count] = codes[_LCD_BIG_DOT];
+      }
+      count++;
+    } else {
+      const char *found = strchr(_lcd_big_chars, symbol);
+      const uint8_t index =
+          (found == NULL || symbol == '\0') ? 10 : found - _lcd_big_chars;
+      const uint8_t *big = height == 2 ? _lcd_big2[index] : _lcd_big4[index];
+      for (uint8_t c = 0; c < 3 && count < width; c++, count++) {
+        for (uint8_t r = 0; r < height; r++) {
+          cells[r][count] = codes[big[r * 3 + c]];
+        }
+      }
+    }
+    // blank column between characters
+    if (i + 1 < length && count < width) {
+      for (uint8_t r = 0; r < height; r++) {
+        cells[r][count] = ' ';
+      }
+      count++;
+    }
+  }
+  for (uint8_t r = 0; r < height; r++) {
+    _lcd_write_cells(handle, cells[r], count, col, row + r);
+  }
+}
+
+/**
+ * @brief Computes the cells of a bar graph and writes the ones that changed.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param value Current value.
+ * @param max Value of a full bar.
+ * @param width Length of the bar in cells.
+ * @param col Column of the left end of the bar.
+ * @param row Row of the bar.
+ */
+void _lcd_write_bar(LCD_Handle *handle, uint16_t value, uint16_t max,
+                    uint8_t width, uint8_t col, uint8_t row) {
+  if (!handle->_bar_ready || col >= handle->_cols ||
+      row >= handle->_numlines || width == 0) {
+    return;
+  }
+  if (width > handle->_cols - col) {
+    width = handle->_cols - col;
+  }
+  if (value > max) {
+    value = max;
+  }
+  uint32_t pixels = max == 0 ? 0 : (uint32_t)value * width * 5 / max;
+  uint8_t cells[40];
+  for (uint8_t i = 0; i < width; i++) {
+    if (pixels >= 5) {
+      cells[i] = handle->_bar_slot + 4;
+      pixels -= 5;
+    } else {
+      cells[i] = pixels == 0 ? ' ' : handle->_bar_slot + pixels - 1;
+      pixels = 0;
+    }
+  }
+  _lcd_write_cells(handle, cells, width, col, row);
+}
+
+/**
+ * @brief Computes the custom characters of the sparkline and sends the rows
+ * that changed.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_update_sparkline(LCD_Handle *handle) {
+  uint8_t rows[64];
+  for (uint8_t cell = 0; cell < handle->_sparkline_cells; cell++) {
+    const uint8_t *levels = handle->_sparkline_levels + cell * 5;
+    for (uint8_t row = 0; row < 8; row++) {
+      uint8_t bits = 0;
+      for (uint8_t x = 0; x < 5; x++) {
+        if (levels[x] > 7 - row) {
+          bits |= 0x10 >> x;
+        }
+      }
+      rows[((handle->_sparkline_slot + cell) << 3) + row] = bits;
+    }
+  }
+  _lcd_write_cgram(handle,
+                   ((1 << handle->_sparkline_cells) - 1)
+                       << handle->_sparkline_slot,
+                   rows);
+}
+
+/**
+ * @brief Sets or clears one pixel of the canvas.
+ *
+ * Pixels outside of the canvas are ignored. A change marks the pixel row of the
+ * cell dirty.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param x Pixel column, 0 is the left edge of the canvas.
+ * @param y Pixel row, 0 is the top edge of the canvas.
+ * @param on true to light the pixel.
+ */
+void _lcd_canvas_set(LCD_Handle *handle, int16_t x, int16_t y, bool on) {
+  if (x < 0 || y < 0 || x >= handle->_canvas_cols * 5 ||
+      y >= handle->_canvas_rows * 8) {
+    return;
+  }
+  const uint8_t cell = (y >> 3) * handle->_canvas_cols + x / 5;
+  const uint8_t bit = 0x10 >> (x % 5);
+  uint8_t *row = &handle->_canvas_pixels[cell][y & 0x7];
+  if (((*row & bit) != 0) != on) {
+    *row ^= bit;
+    handle->_canvas_dirty[cell] |= 1 << (y & 0x7);
+  }
+}
+
+/**
+ * @brief Uploads the rows of custom characters that changed.
+ *
+ * Rows equal to the shadow copy of the CGRAM are skipped, runs of changed rows
+ * are written with the address counter incrementing, even across characters,
+ * all in one burst. Before the display is ready nothing is sent.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param slots Bitmask of the custom characters to write.
+ * @param rows Image of the CGRAM, 8 pixel rows for every custom character;
+ *             only the rows of `slots` are read.
+ */
+void _lcd_write_cgram(LCD_Handle *handle, uint8_t slots, const uint8_t *rows) {
+  if (handle->_init_state != _LCD_INIT_READY) {
+    return;
+  }
+  const uint8_t address = handle->_address;
+  const bool cgram_selected = handle->_cgram_selected;
+  bool sequential = false;
+  uint8_t displaymode = 0;
+  for (uint8_t slot = 0; slot < 8; slot++) {
+    if (!(slots & (1 << slot))) {
+      continue;
+    }
+    for (uint8_t row = 0; row < 8; row++) {
+      const uint8_t target = (slot << 3) + row;
+      const uint8_t bits = rows[target];
+      if ((handle->_cgram_valid & (1 << slot)) &&
+          handle->_cgram[target] == bits) {
+        continue;
+      }
+      if (!sequential) {
+        displaymode = _lcd_begin_sequential(handle);
+        sequential = true;
+      }
+      if (!handle->_cgram_selected || handle->_address != target) {
+        _lcd_send_command(handle, LCD_SETCGRAMADDR | target);
+      }
+      _lcd_send_data(handle, bits);
+    }
+    handle->_cgram_valid |= 1 << slot;
+  }
+  if (sequential) {
+    _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+  }
+}
+
+/**
+ * @brief Lists the cells overlapped by the visible sprites.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cells Receives the cell indexes (row-major), each one once.
+ * @return uint8_t Number of cells.
+ */
+uint8_t _lcd_sprite_cells(LCD_Handle *handle, uint8_t *cells) {
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < LCD_MAX_SPRITES; i++) {
+    const LCD_Sprite *sprite = &handle->_sprites[i];
+    if (!sprite->visible || sprite->x + 4 < 0 || sprite->y + 7 < 0) {
+      continue;
+    }
+    const int16_t first_col = sprite->x < 0 ? 0 : sprite->x / 5;
+    const int16_t first_row = sprite->y < 0 ? 0 : sprite->y / 8;
+    for (int16_t row = first_row;
+         row <= (sprite->y + 7) / 8 && row < handle->_numlines; row++) {
+      for (int16_t col = first_col;
+           col <= (sprite->x + 4) / 5 && col < handle->_cols; col++) {
+        const uint8_t cell = row * handle->_cols + col;
+        if (memchr(cells, cell, count) == NULL) {
+          cells[count++] = cell;
+        }
+      }
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief Draws the sprites over the character of a cell.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param cell Cell index (row-major).
+ * @param background Character code of the cell without sprites.
+ * @param planned true if background is an index into _plan_codepoints.
+ * @param rows Receives the 8 pixel rows of the cell.
+ */
+void _lcd_sprite_composite(LCD_Handle *handle, uint8_t cell,
+                           uint8_t background, bool planned, uint8_t *rows) {
+  // only custom characters and planned glyphs have known pixels
+  const uint8_t code = background & 0xF7;
+  const _LCD_Glyph *glyph =
+      planned ? _lcd_find_glyph(handle->_plan_codepoints[background]) : NULL;
+  if (glyph != NULL) {
+    memcpy(rows, glyph->rows, 8);
+  } else if (!planned && code < handle->_sprite_slot &&
+             (handle->_cgram_valid & (1 << code))) {
+    memcpy(rows, handle->_cgram + (code << 3), 8);
+  } else {
+    memset(rows, 0, 8);
+  }
+  const int16_t left = (cell % handle->_cols) * 5;
+  const int16_t top = (cell / handle->_cols) * 8;
+  for (uint8_t i = 0; i < LCD_MAX_SPRITES; i++) {
+    const LCD_Sprite *sprite = &handle->_sprites[i];
+    const int16_t dx = sprite->x - left;
+    const int16_t dy = sprite->y - top;
+    if (!sprite->visible || dx <= -5 || dx >= 5 || dy <= -8 || dy >= 8) {
+      continue;
+    }
+    for (int16_t row = 0; row < 8; row++) {
+      if (row - dy < 0 || row - dy >= 8) {
+        continue;
+      }
+      const uint8_t bits = sprite->rows[row - dy];
+      rows[row] |= (dx >= 0 ? bits >> dx : bits << -dx) & 0x1F;
+    }
+  }
+}
+
+/**
+ * @brief Draws the visible part of the ticker text into its custom characters.
+ *
+ * The text is laid out after a blank stretch as wide as the ticker, every
+ * character 5 pixel columns and a blank one. The font columns are turned into
+ * the pixel rows of the custom characters and the rows that changed are sent.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_render_ticker(LCD_Handle *handle) {
+  const uint8_t width = handle->_ticker_cells * 5;
+  // index of the character and its pixel column at the left end
+  int32_t offset = (int32_t)handle->_ticker_position - width;
+  size_t index = 0;
+  uint8_t column = 0;
+  if (offset > 0) {
+    index = offset / 6;
+    column = offset - index * 6;
+    offset = 0;
+  }
+  uint8_t rows[64] = {0};
+  for (uint8_t x = 0; x < width; x++) {
+    uint8_t bits = 0;
+    if (offset < 0) {
+      offset++;
+    } else if (index < handle->_ticker_length) {
+      if (column < 5) {
+        uint8_t symbol = handle->_ticker_text[index];
+        if (symbol < 0x20 || symbol > 0x7E) {
+          symbol = '?';
+        }
+        bits = _lcd_font[symbol - 0x20][column];
+      }
+      if (++column == 6) {
+        column = 0;
+        index++;
+      }
+    }
+    if (bits == 0) {
+      continue;
+    }
+    uint8_t *glyph = rows + (handle->_ticker_slot + x / 5) * 8;
+    const uint8_t mask = 0x10 >> (x % 5);
+    for (uint8_t row = 0; row < 8; row++, bits >>= 1) {
+      if (bits & 1) {
+        glyph[row] |= mask;
+      }
+    }
+  }
+  _lcd_write_cgram(handle,
+                   ((1 << handle->_ticker_cells) - 1) << handle->_ticker_slot,
+                   rows);
+}
+
+/**
+ * @brief Starts the animation alarm if there is something to animate.
+ *
+ * A running alarm is moved forward if an animation is due before it fires.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+void _lcd_start_animations(LCD_Handle *handle) {
+  if (handle->_init_state != _LCD_INIT_READY ||
+      !(handle->_sent_displaycontrol & LCD_DISPLAYON)) {
+    return;
+  }
+  uint64_t due = UINT64_MAX;
+  for (uint8_t slot = 0; slot < 8; slot++) {
+    const LCD_Animation *animation = &handle->_animations[slot];
+    if (animation->count > 0 && animation->due_us < due) {
+      due = animation->due_us;
+    }
+  }
+  if (due == UINT64_MAX) {
+    return;
+  }
+  if (handle->_animation_alarm > 0) {
+    if (due >= handle->_animation_due) {
+      return;
+    }
+    cancel_alarm(handle->_animation_alarm);
+    handle->_animation_alarm = 0;
+  }
+  // set first, the alarm updates it if it fires right away
+  handle->_animation_due = due;
+  const alarm_id_t alarm = add_alarm_at(from_us_since_boot(due),
+                                        _lcd_animation_alarm, handle, true);
+  if (alarm > 0) {
+    handle->_animation_alarm = alarm;
+  }
+}
+
+/**
+ * @brief Alarm callback advancing the animations started by lcd_animate().
+ *
+ * The frames of all animations that are due are collected into one CGRAM
+ * image and sent in a single burst. This runs in interrupt context, so the
+ * transport must only busy-wait (see _LCD_SLEEP_US). The alarm tries again
+ * shortly if it interrupted a transfer or a stream is being recorded, and stops
+ * when the display is off or nothing is animated anymore.
+ *
+ * @param id Alarm ID (unused).
+ * @param user_data Pointer to the LCD handle.
+ * @return int64_t 0 to stop, otherwise the time to the next frame.
+ */
+int64_t _lcd_animation_alarm(alarm_id_t id, void *user_data) {
+  (void)id;
+  LCD_Handle *handle = (LCD_Handle *)user_data;
+  if (!(handle->_sent_displaycontrol & LCD_DISPLAYON)) {
+    handle->_animation_alarm = 0;
+    return 0;
+  }
+  const uint64_t now = time_us_64();
+  if (handle->_bus_depth > 0 || handle->_record != NULL) {
+    handle->_animation_due = now + 100;
+    return 100;
+  }
+  uint64_t next = UINT64_MAX;
+  uint8_t rows[64];
+  uint8_t slots = 0;
+  for (uint8_t slot = 0; slot < 8; slot++) {
+    LCD_Animation *animation = &handle->_animations[slot];
+    if (animation->count == 0) {
+      continue;
+    }
+    if (animation->due_us <= now) {
+      if (++animation->frame >= animation->count) {
+        animation->frame = 0;
+      }
+      memcpy(rows + (slot << 3), animation->frames + (animation->frame << 3),
+             8);
+      slots |= 1 << slot;
+      animation->due_us += animation->period_us;
+      if (animation->due_us <= now) {
+        // fell behind, skip the missed frames' deadlines
+        animation->due_us = now + animation->period_us;
+      }
+    }
+    if (animation->due_us < next) {
+      next = animation->due_us;
+    }
+  }
+  _lcd_write_cgram(handle, slots, rows);
+  if (next == UINT64_MAX) {
+    handle->_animation_alarm = 0;
+    return 0;
   }
+  handle->_animation_due = next;
+  const int64_t delay = (int64_t)(next - time_us_64());
+  return delay > 0 ? delay : 1;
 }
 
-// ########################################################################## //
-//                                                                            //
-//                      Private function implementation                       //
-//                                                                            //
-// ########################################################################## //
-
 /**
- * @brief Initializes the LCD with the specified settings and returns a handle.
+ * @brief Translates the next character of a string to character codes.
  *
- * This function sets up the LCD controller with the given parameters such as
- * the number of columns and rows, character size, and GPIO pin assignments.
- * It performs the necessary initialization sequence as specified in the
- * LCD datasheet and returns a pointer to the initialized LCD handle.
+ * This function decodes one UTF-8 sequence (or takes one byte with
+ * LCD_CHARSET_RAW) and advances the text past it. Malformed sequences become '?'
+ * and never consume the terminating null character.
  *
- * @param cols Number of columns of the LCD display.
- * @param rows Number of rows of the LCD display.
- * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
- * @param rs GPIO pin number for the RS (Register Select) pin.
- * @param rw GPIO pin number for the RW (Read/Write) pin (255 if not used).
- * @param enable GPIO pin number for the Enable pin.
- * @param d0 GPIO pin number for data line 0.
- * @param d1 GPIO pin number for data line 1.
- * @param d2 GPIO pin number for data line 2.
- * @param d3 GPIO pin number for data line 3.
- * @param d4 GPIO pin number for data line 4.
- * @param d5 GPIO pin number for data line 5.
- * @param d6 GPIO pin number for data line 6.
- * @param d7 GPIO pin number for data line 7.
- * @param eightbitmode Boolean flag to specify if 8-bit mode is used.
- * @return LCD_Handle* Pointer to the initialized LCD handle, or NULL if initialization failed.
+ * @param handle Pointer to the LCD handle.
+ * @param text Pointer to the text, advanced past the character.
+ * @param codes Receives the character codes.
+ * @return uint8_t Number of character codes (1 or 2).
  */
-LCD_Handle *_lcd_init(uint8_t cols, uint8_t rows, uint8_t charsize, uint8_t rs,
-                      uint8_t rw, uint8_t enable, uint8_t d0, uint8_t d1,
-                      uint8_t d2, uint8_t d3, uint8_t d4, uint8_t d5,
-                      uint8_t d6, uint8_t d7, bool eightbitmode) {
-  LCD_Handle *handle = (LCD_Handle *)malloc(sizeof(LCD_Handle));
-  if (handle == NULL) {
-    return NULL;
-  }
-
-  // SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
-  // according to datasheet, we need at least 40 ms after power rises above 2.7
-  // V before sending commands. Microcontroller can turn on way before 4.5 V so
-  // we'll wait 50
-  sleep_ms(50);
-
-  handle->_rs_pin = rs;
-  handle->_rw_pin = rw;
-  handle->_enable_pin = enable;
-
-  handle->_data_pins[0] = d0;
-  handle->_data_pins[1] = d1;
-  handle->_data_pins[2] = d2;
-  handle->_data_pins[3] = d3;
-  handle->_data_pins[4] = d4;
-  handle->_data_pins[5] = d5;
-  handle->_data_pins[6] = d6;
-  handle->_data_pins[7] = d7;
+uint8_t _lcd_encode(LCD_Handle *handle, const char **text, uint8_t codes[2]) {
+  return _lcd_translate(handle, _lcd_decode(handle, text), codes);
+}
 
-  if (eightbitmode) {
-    handle->_displayfunction = LCD_8BITMODE | LCD_1LINE | LCD_5x8DOTS;
-    handle->_data_pins_mask = (0x1 << d0) | (0x1 << d1) | (0x1 << d2) |
-                              (0x1 << d3) | (0x1 << d4) | (0x1 << d5) |
-                              (0x1 << d6) | (0x1 << d7);
-  } else {
-    handle->_displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
-    handle->_data_pins_mask =
-        (0x1 << d0) | (0x1 << d1) | (0x1 << d2) | (0x1 << d3);
+/**
+ * @brief Decodes the next character of a string.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param text Pointer to the text, advanced past the character.
+ * @return uint32_t Unicode code point, or the byte with LCD_CHARSET_RAW.
+ */
+uint32_t _lcd_decode(LCD_Handle *handle, const char **text) {
+  const uint8_t *next = (const uint8_t *)*text;
+  uint32_t codepoint = *next++;
+  if (handle->_charset != LCD_CHARSET_RAW && codepoint >= 0x80) {
+    const uint8_t extra = codepoint >= 0xF8   ? 0
+                          : codepoint >= 0xF0 ? 3
+                          : codepoint >= 0xE0 ? 2
+                          : codepoint >= 0xC0 ? 1
+                                              : 0;
+    codepoint = extra == 0 ? '?' : codepoint & (0x3F >> extra);
+    for (uint8_t i = 0; i < extra; i++) {
+      if ((*next & 0xC0) != 0x80) {
+        codepoint = '?';
+        break;
+      }
+      codepoint = (codepoint << 6) | (*next++ & 0x3F);
+    }
   }
+  *text = (const char *)next;
+  return codepoint;
+}
 
-  _lcd_init_pins(handle);
-  _lcd_setup(handle, cols, rows, charsize);
-
-  lcd_clear(handle);
-  lcd_home(handle);
-
-  return handle;
+/**
+ * @brief Translates a decoded character to character codes.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param codepoint Value returned by _lcd_decode().
+ * @param codes Receives the character codes.
+ * @return uint8_t Number of character codes (1 or 2).
+ */
+uint8_t _lcd_translate(LCD_Handle *handle, uint32_t codepoint,
+                       uint8_t codes[2]) {
+  if (handle->_charset == LCD_CHARSET_RAW) {
+    codes[0] = codepoint;
+    return 1;
+  }
+  return _lcd_lookup(handle, codepoint, codes);
 }
 
 /**
- * @brief Configures the LCD display settings.
+ * @brief Finds the character codes of a Unicode code point.
  *
- * This function sets the display parameters including the number of lines, character size,
- * and initializes the LCD in either 8-bit or 4-bit mode based on the settings provided.
+ * The character ROM is tried first, then the glyph cache, then the ASCII
+ * replacements.
  *
  * @param handle Pointer to the LCD handle.
- * @param cols Number of columns of the LCD display.
- * @param rows Number of rows of the LCD display.
- * @param charsize Character size (5x8 dots [LCD_5x8DOTS] or 5x10 dots [LCD_5x10DOTS]).
+ * @param codepoint Unicode code point.
+ * @param codes Receives the character codes.
+ * @return uint8_t Number of character codes (1 or 2).
  */
-void _lcd_setup(LCD_Handle *handle, uint8_t cols, uint8_t rows,
-                uint8_t charsize) {
-  if (rows > 1) {
-    handle->_displayfunction |= LCD_2LINE;
+uint8_t _lcd_lookup(LCD_Handle *handle, uint32_t codepoint, uint8_t codes[2]) {
+  const uint8_t count = _lcd_lookup_rom(handle, codepoint, codes);
+  if (count != 0) {
+    return count;
   }
-  handle->_numlines = rows;
-
-  handle->_row_offsets[0] = 0x00;
-  handle->_row_offsets[1] = 0x40;
-  handle->_row_offsets[2] = 0x00 + cols;
-  handle->_row_offsets[3] = 0x40 + cols;
-
-  // for some 1 line displays you can select a 10 pixel high font
-  if ((charsize != LCD_5x8DOTS) && (rows == 1)) {
-    handle->_displayfunction |= LCD_5x10DOTS;
+  const _LCD_Glyph *glyph = _lcd_find_glyph(codepoint);
+  const int slot = glyph != NULL ? _lcd_glyph_slot(handle, glyph) : -1;
+  if (slot >= 0) {
+    codes[0] = slot;
+    return 1;
   }
+  return _lcd_transliterate(codepoint, codes);
+}
 
-  // put the LCD into 8 bit or 4 bit mode
-  if (handle->_displayfunction & LCD_8BITMODE) {
-    // this is according to the Hitachi HD44780 datasheet
-    // page 45 figure 23
-
-    // Send function set command sequence
-    _lcd_write_8_bits(handle, LCD_FUNCTIONSET | handle->_displayfunction);
-    sleep_ms(5);  // wait more than 4.1 ms
-
-    // second try
-    _lcd_write_8_bits(handle, LCD_FUNCTIONSET | handle->_displayfunction);
-    sleep_ms(5);
-
-    // third go
-    _lcd_write_8_bits(handle, LCD_FUNCTIONSET | handle->_displayfunction);
-    sleep_ms(5);
-  } else {
-    // this is according to the Hitachi HD44780 datasheet
-    // page 46 figure 24
-
-    // we start in 8bit mode, try to set 4 bit mode
-    _lcd_write_4_bits(handle, 0x03);
-    sleep_ms(5);  // wait min 4.1ms
-
-    // second try
-    _lcd_write_4_bits(handle, 0x03);
-    sleep_ms(5);  // wait min 4.1ms
-
-    // third go!
-    _lcd_write_4_bits(handle, 0x03);
-    sleep_ms(5);
-
-    // finally, set to 4-bit interface
-    _lcd_write_4_bits(handle, 0x02);
-    sleep_ms(5);
+/**
+ * @brief Finds the character ROM codes of a Unicode code point.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param codepoint Unicode code point.
+ * @param codes Receives the character codes.
+ * @return uint8_t Number of character codes (1 or 2), 0 if the ROM of the
+ *         display lacks the character.
+ */
+uint8_t _lcd_lookup_rom(LCD_Handle *handle, uint32_t codepoint,
+                        uint8_t codes[2]) {
+  const bool a00 = handle->_charset == LCD_CHARSET_A00;
+  // the A00 ROM has a yen sign and an arrow in place of '\' and '~'
+  if (codepoint < 0x80 && !(a00 && (codepoint == '\\' || codepoint == '~'))) {
+    codes[0] = codepoint;
+    return 1;
+  }
+  if (a00 && codepoint >= 0xFF61 && codepoint <= 0xFF9F) {
+    // half-width katakana are in JIS X 0201 order
+    codes[0] = codepoint - 0xFF61 + 0xA1;
+    return 1;
   }
+  const _LCD_RomEntry *entry =
+      a00 ? _lcd_find_entry(_lcd_rom_a00,
+                            sizeof(_lcd_rom_a00) / sizeof(*_lcd_rom_a00),
+                            codepoint)
+          : _lcd_find_entry(_lcd_rom_a02,
+                            sizeof(_lcd_rom_a02) / sizeof(*_lcd_rom_a02),
+                            codepoint);
+  if (entry == NULL) {
+    return 0;
+  }
+  codes[0] = entry->codes[0];
+  codes[1] = entry->codes[1];
+  return codes[1] != 0 ? 2 : 1;
+}
 
-  // finally, set # lines, font size, etc.
-  _lcd_send_command(handle, LCD_FUNCTIONSET | handle->_displayfunction);
+/**
+ * @brief Finds the ASCII replacement of a Unicode code point.
+ *
+ * @param codepoint Unicode code point.
+ * @param codes Receives the character codes.
+ * @return uint8_t Number of character codes (1 or 2), the code is '?' if
+ *         there is no replacement.
+ */
+uint8_t _lcd_transliterate(uint32_t codepoint, uint8_t codes[2]) {
+  const _LCD_RomEntry *entry = _lcd_find_entry(
+      _lcd_transliterations,
+      sizeof(_lcd_transliterations) / sizeof(*_lcd_transliterations),
+      codepoint);
+  if (entry == NULL) {
+    codes[0] = '?';
+    return 1;
+  }
+  codes[0] = entry->codes[0];
+  codes[1] = entry->codes[1];
+  return codes[1] != 0 ? 2 : 1;
+}
 
-  // turn the display on with no cursor or blinking default
-  handle->_displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
-  _lcd_send_command(handle, LCD_DISPLAYCONTROL | handle->_displaycontrol);
+/**
+ * @brief Binary search in a table sorted by code point.
+ *
+ * @param table Table to search.
+ * @param count Number of entries.
+ * @param codepoint Unicode code point.
+ * @return const _LCD_RomEntry* The entry, or NULL if there is none.
+ */
+const _LCD_RomEntry *_lcd_find_entry(const _LCD_RomEntry *table, size_t count,
+                                     uint32_t codepoint) {
+  size_t low = 0;
+  size_t high = count;
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (table[middle].codepoint == codepoint) {
+      return &table[middle];
+    }
+    if (table[middle].codepoint < codepoint) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return NULL;
+}
 
-  // Initialize to default text direction (for romance languages)
-  handle->_displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-  // set the entry mode
-  _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
+/**
+ * @brief Binary search for the CGRAM bitmap of a code point.
+ *
+ * @param codepoint Unicode code point.
+ * @return const _LCD_Glyph* The bitmap, or NULL if there is none.
+ */
+const _LCD_Glyph *_lcd_find_glyph(uint32_t codepoint) {
+  size_t low = 0;
+  size_t high = sizeof(_lcd_glyphs) / sizeof(*_lcd_glyphs);
+  while (low < high) {
+    const size_t middle = (low + high) / 2;
+    if (_lcd_glyphs[middle].codepoint == codepoint) {
+      return &_lcd_glyphs[middle];
+    }
+    if (_lcd_glyphs[middle].codepoint < codepoint) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return NULL;
 }
 
 /**
- * @brief Initializes the GPIO pins used for the LCD interface.
+ * @brief Finds or fills a CGRAM slot with a glyph.
  *
- * This function sets the direction and initial state of the GPIO pins
- * associated with the LCD data and control signals.
+ * A slot that already holds the glyph is reused. Otherwise the next slot in
+ * round-robin order that wasn't created by lcd_create_char() and isn't shown
+ * on the display or waiting in the frame buffer gets the glyph uploaded.
  *
  * @param handle Pointer to the LCD handle.
+ * @param glyph Glyph to show.
+ * @return int The slot (character code 0-7), or -1 if none is free.
  */
-void _lcd_init_pins(LCD_Handle *handle) {
-  gpio_init_mask(handle->_data_pins_mask);
-  gpio_set_dir_out_masked(handle->_data_pins_mask);
-  gpio_put_masked(handle->_data_pins_mask, 0);
-
-  gpio_init(handle->_rs_pin);
-  gpio_set_dir(handle->_rs_pin, GPIO_OUT);
-  gpio_put(handle->_rs_pin, 0);
+int _lcd_glyph_slot(LCD_Handle *handle, const _LCD_Glyph *glyph) {
+  for (uint8_t slot = 0; slot < 8; slot++) {
+    if (handle->_glyph_codepoints[slot] == glyph->codepoint) {
+      return slot;
+    }
+  }
+  if (handle->_init_state != _LCD_INIT_READY) {
+    return -1;
+  }
+  for (uint8_t i = 0; i < 8; i++) {
+    const uint8_t slot = (handle->_glyph_next + i) & 0x7;
+    if ((handle->_glyph_reserved & (1 << slot)) ||
+        _lcd_code_in_use(handle, slot)) {
+      continue;
+    }
+    const uint8_t address = handle->_address;
+    const bool cgram_selected = handle->_cgram_selected;
+    const uint8_t displaymode = _lcd_begin_sequential(handle);
+    _lcd_send_command(handle, LCD_SETCGRAMADDR | (slot << 3));
+    for (uint8_t row = 0; row < 8; row++) {
+      _lcd_send_data(handle, glyph->rows[row]);
+    }
+    _lcd_end_sequential(handle, displaymode, address, cgram_selected);
+    handle->_cgram_valid |= 1 << slot;
+    handle->_glyph_codepoints[slot] = glyph->codepoint;
+    handle->_glyph_next = (slot + 1) & 0x7;
+    return slot;
+  }
+  return -1;
+}
 
-  gpio_init(handle->_enable_pin);
-  gpio_set_dir(handle->_enable_pin, GPIO_OUT);
-  gpio_put(handle->_enable_pin, 0);
+/**
+ * @brief Checks if a custom character is shown or about to be shown.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param code Custom character code (0-7).
+ * @return true if the shadow copy or the frame buffer contains the code (or
+ *         its alias code + 8).
+ */
+bool _lcd_code_in_use(LCD_Handle *handle, uint8_t code) {
+  const size_t cells = (size_t)handle->_cols * handle->_numlines;
+  for (size_t i = 0; i < cells; i++) {
+    uint8_t symbol = handle->_frame[i];
+    if (handle->_attributes[i] & _LCD_ATTR_GLYPH) {
+      // 0xFF if the glyph shows its fallback
+      symbol = handle->_plan_codes[symbol];
+    }
+    if ((handle->_shadow[i] & 0xF7) == code || (symbol & 0xF7) == code) {
+      return true;
+    }
+  }
+  return false;
+}
 
-  if (handle->_rw_pin != 255) {
-    gpio_init(handle->_rw_pin);
-    gpio_set_dir(handle->_rw_pin, GPIO_OUT);
-    gpio_put(handle->_rw_pin, 0);
+/**
+ * @brief Switches the entry mode to left-to-right without display shift.
+ *
+ * Bulk transfers write or read runs of cells with the address counter
+ * auto-incrementing, which right-to-left entry and autoscroll would break.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return uint8_t The previous entry mode, for _lcd_end_sequential().
+ */
+uint8_t _LCD_RAM_FUNC(_lcd_begin_sequential)(LCD_Handle *handle) {
+  const uint8_t displaymode = handle->_displaymode;
+  handle->_displaymode = LCD_ENTRYLEFT;
+  if (handle->_sent_displaymode != LCD_ENTRYLEFT) {
+    _lcd_send_command(handle, LCD_ENTRYMODESET | handle->_displaymode);
   }
+  return displaymode;
 }
 
 /**
- * @brief Deinitializes the GPIO pins used for the LCD interface.
+ * @brief Restores the entry mode and the address counter after a bulk transfer.
  *
- * This function resets the GPIO pins to their default state, effectively
- * releasing them from their LCD-specific configuration.
+ * The entry mode is sent again before the next character (see _lcd_send_data()),
+ * so back-to-back bulk transfers don't switch it back and forth.
  *
  * @param handle Pointer to the LCD handle.
+ * @param displaymode Entry mode returned by _lcd_begin_sequential().
+ * @param address Address counter before the transfer.
+ * @param cgram_selected true if the address counter pointed into CGRAM.
  */
-void _lcd_deinit_pins(LCD_Handle *handle) {
-  gpio_set_function_masked(handle->_data_pins_mask, GPIO_FUNC_NULL);
-  gpio_set_function(handle->_rs_pin, GPIO_FUNC_NULL);
-  gpio_set_function(handle->_enable_pin, GPIO_FUNC_NULL);
-  if (handle->_rw_pin != 255) {
-    gpio_set_function(handle->_rw_pin, GPIO_FUNC_NULL);
+void _LCD_RAM_FUNC(_lcd_end_sequential)(LCD_Handle *handle,
+                                        uint8_t displaymode, uint8_t address,
+                                        bool cgram_selected) {
+  handle->_displaymode = displaymode;
+  if (cgram_selected) {
+    _lcd_send_command(handle, LCD_SETCGRAMADDR | address);
+  } else if (handle->_cgram_selected || handle->_address != address) {
+    _lcd_send_command(handle, LCD_SETDDRAMADDR | address);
   }
 }
 
 /**
- * @brief Sends a command to the LCD.
+ * @brief Updates the shadow state after an instruction was sent.
  *
- * This function sends a command byte to the LCD. It waits for the LCD to be
- * ready if the RW pin is used, sets the RS pin to command mode, and sends the
- * command in either 8-bit or 4-bit mode depending on the LCD configuration.
+ * This function follows the address counter and mirrors the side effects of the
+ * instruction, so the shadow buffers always match what the controller holds.
  *
  * @param handle Pointer to the LCD handle.
- * @param command Command byte to be sent to the LCD.
+ * @param command Command byte sent to the LCD.
  */
-void _lcd_send_command(LCD_Handle *handle, uint8_t command) {
-  if (handle->_rw_pin != 255) {
-    while (_lcd_busy(handle)) {
-      sleep_us(3);
+void _LCD_RAM_FUNC(_lcd_track_command)(LCD_Handle *handle, uint8_t command) {
+  if (command & LCD_SETDDRAMADDR) {
+    handle->_address = command & 0x7F;
+    handle->_cgram_selected = false;
+  } else if (command & LCD_SETCGRAMADDR) {
+    handle->_address = command & 0x3F;
+    handle->_cgram_selected = true;
+  } else if (command & LCD_FUNCTIONSET) {
+    // no effect on the address counter
+  } else if (command & LCD_CURSORSHIFT) {
+    if (command & LCD_DISPLAYMOVE) {
+      _lcd_track_shift(handle, command & LCD_MOVERIGHT);
+    } else {
+      handle->_address = _lcd_next_address(handle, handle->_address,
+                                           command & LCD_MOVERIGHT);
     }
+  } else if (command & LCD_DISPLAYCONTROL) {
+    handle->_sent_displaycontrol = command & 0x07;
+  } else if (command & LCD_ENTRYMODESET) {
+    handle->_sent_displaymode = command & 0x03;
+  } else if (command & LCD_RETURNHOME) {
+    handle->_address = 0;
+    handle->_cgram_selected = false;
+    handle->_shift = 0;
+  } else if (command & LCD_CLEARDISPLAY) {
+    // memset() may live in flash, see LCD_CONFIG_RUN_FROM_RAM
+    for (size_t i = 0; i < (size_t)handle->_cols * handle->_numlines; i++) {
+      handle->_shadow[i] = ' ';
+    }
+    handle->_address = 0;
+    handle->_cgram_selected = false;
+    handle->_shift = 0;
+    handle->_offscreen_dirty = false;
+    // clearing also sets the entry mode to increment
+    handle->_sent_displaymode |= LCD_ENTRYLEFT;
   }
-  gpio_put(handle->_rs_pin, 0);
-  if (handle->_displayfunction & LCD_8BITMODE) {
-    _lcd_write_8_bits(handle, command);
+}
+
+/**
+ * @brief Updates the shadow state after a data byte was written.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param data Data byte written to the LCD.
+ */
+void _LCD_RAM_FUNC(_lcd_track_data)(LCD_Handle *handle, uint8_t data) {
+  if (handle->_cgram_selected) {
+    handle->_cgram[handle->_address & 0x3F] = data & 0x1F;
   } else {
-    _lcd_write_4_bits(handle, command >> 4);
-    _lcd_write_4_bits(handle, command);
+    const int cell = _lcd_cell_index(handle, handle->_address);
+    if (cell >= 0) {
+      handle->_shadow[cell] = data;
+      if (!handle->_redrawing) {
+        // a direct write also replaces whatever was buffered for the cell
+        handle->_frame[cell] = data;
+        if (handle->_attributes[cell] & _LCD_ATTR_GLYPH) {
+          handle->_attributes[cell] &= ~_LCD_ATTR_GLYPH;
+          handle->_attribute_cells -= handle->_attributes[cell] == 0;
+        }
+      }
+    } else {
+      handle->_offscreen_dirty = true;
+    }
+    if (handle->_sent_displaymode & LCD_ENTRYSHIFTINCREMENT) {
+      // the display moves against the cursor to keep it in place
+      _lcd_track_shift(handle, !(handle->_sent_displaymode & LCD_ENTRYLEFT));
+    }
   }
+  handle->_address = _lcd_next_address(
+      handle, handle->_address, handle->_sent_displaymode & LCD_ENTRYLEFT);
 }
 
 /**
- * @brief Sends data to the LCD.
+ * @brief Follows the display shift by one position.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param right true if the display moved right, false if it moved left.
+ */
+void _LCD_RAM_FUNC(_lcd_track_shift)(LCD_Handle *handle, bool right) {
+  const uint8_t length = (handle->_displayfunction & LCD_2LINE) ? 40 : 80;
+  if (right) {
+    handle->_shift = handle->_shift + 1 == length ? 0 : handle->_shift + 1;
+  } else {
+    handle->_shift = (handle->_shift == 0 ? length : handle->_shift) - 1;
+  }
+}
+
+/**
+ * @brief Computes the address counter after a step in either direction.
  *
- * This function sends a data byte to the LCD. It waits for the LCD to be
- * ready if the RW pin is used, sets the RS pin to data mode, and sends the
- * data in either 8-bit or 4-bit mode depending on the LCD configuration.
+ * This function wraps the address the same way as the controller: CGRAM addresses
+ * wrap at 64, DDRAM addresses jump between the lines in 2-line mode and wrap at
+ * 80 in 1-line mode.
  *
  * @param handle Pointer to the LCD handle.
- * @param data Data byte to be sent to the LCD.
+ * @param address Current address.
+ * @param increment true to step forward, false to step backward.
+ * @return uint8_t The next address.
  */
-void _lcd_send_data(LCD_Handle *handle, uint8_t data) {
-  if (handle->_rw_pin != 255) {
-    while (_lcd_busy(handle)) {
-      sleep_us(3);
+uint8_t _LCD_RAM_FUNC(_lcd_next_address)(LCD_Handle *handle, uint8_t address,
+                                         bool increment) {
+  if (handle->_cgram_selected) {
+    return (address + (increment ? 1 : -1)) & 0x3F;
+  }
+  if (handle->_displayfunction & LCD_2LINE) {
+    if (increment) {
+      return address == 0x27 ? 0x40 : address == 0x67 ? 0x00 : address + 1;
     }
+    return address == 0x40 ? 0x27 : address == 0x00 ? 0x67 : address - 1;
   }
-  gpio_put(handle->_rs_pin, 1);
-  if (handle->_displayfunction & LCD_8BITMODE) {
-    _lcd_write_8_bits(handle, data);
-  } else {
-    _lcd_write_4_bits(handle, data >> 4);
-    _lcd_write_4_bits(handle, data);
+  if (increment) {
+    return address >= 0x4F ? 0x00 : address + 1;
+  }
+  return address == 0x00 ? 0x4F : address - 1;
+}
+
+/**
+ * @brief Finds the shadow buffer cell shown at a DDRAM address.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param address DDRAM address.
+ * @return int Index into the shadow buffer, or -1 if the address is not visible
+ *         without shifting the display.
+ */
+int _LCD_RAM_FUNC(_lcd_cell_index)(LCD_Handle *handle, uint8_t address) {
+  for (uint8_t row = 0; row < handle->_numlines; row++) {
+    const uint8_t offset = handle->_row_offsets[row];
+    if (address >= offset && address < offset + handle->_cols) {
+      return row * handle->_cols + (address - offset);
+    }
   }
+  return -1;
 }
 
 /**
@@ -726,36 +5526,43 @@ void _lcd_send_data(LCD_Handle *handle, uint8_t data) {
  * @param handle Pointer to the LCD handle.
  * @return uint8_t The command byte read from the LCD.
  */
-uint8_t _lcd_read_command(LCD_Handle *handle) {
-  gpio_put(handle->_rs_pin, 0);
+uint8_t _LCD_RAM_FUNC(_lcd_read_command)(LCD_Handle *handle) {
+  handle->_bus_depth++;
+  gpio_put(_LCD_RS_PIN(handle), 0);
   uint8_t command = 0;
-  if (handle->_displayfunction & LCD_8BITMODE) {
+  if (_LCD_8BIT(handle)) {
     command = _lcd_read_8_bits(handle);
   } else {
-    command = _lcd_read_4_bits(handle) << 4;
-    command |= _lcd_read_4_bits(handle);
+    command = _lcd_read_2x4_bits(handle);
   }
+  handle->_bus_depth--;
   return command;
 }
 
 /**
  * @brief Reads a data byte from the LCD.
  *
- * This function reads a data byte from the LCD. It sets the RS pin to data mode
- * and reads the data in either 8-bit or 4-bit mode depending on the LCD configuration.
+ * This function reads a data byte from the LCD. It waits for the LCD to be ready,
+ * sets the RS pin to data mode and reads the data in either 8-bit or 4-bit mode
+ * depending on the LCD configuration. Like a write, the read moves the address
+ * counter.
  *
  * @param handle Pointer to the LCD handle.
  * @return uint8_t The data byte read from the LCD.
  */
-uint8_t _lcd_read_data(LCD_Handle *handle) {
-  gpio_put(handle->_rs_pin, 1);
+uint8_t _LCD_RAM_FUNC(_lcd_read_data)(LCD_Handle *handle) {
+  handle->_bus_depth++;
+  _lcd_wait_ready(handle);
+  gpio_put(_LCD_RS_PIN(handle), 1);
   uint8_t data = 0;
-  if (handle->_displayfunction & LCD_8BITMODE) {
+  if (_LCD_8BIT(handle)) {
     data = _lcd_read_8_bits(handle);
   } else {
-    data = _lcd_read_4_bits(handle) << 4;
-    data |= _lcd_read_4_bits(handle);
+    data = _lcd_read_2x4_bits(handle);
   }
+  handle->_address = _lcd_next_address(
+      handle, handle->_address, handle->_sent_displaymode & LCD_ENTRYLEFT);
+  handle->_bus_depth--;
   return data;
 }
 
@@ -768,23 +5575,23 @@ uint8_t _lcd_read_data(LCD_Handle *handle) {
  * @param handle Pointer to the LCD handle.
  * @param data 8-bit data byte to be written to the LCD.
  */
-void _lcd_write_8_bits(LCD_Handle *handle, uint8_t data) {
-  if (handle->_rw_pin != 255) {
-    gpio_put(handle->_rw_pin, 0);
-    sleep_us(1);
-    gpio_set_dir_out_masked(handle->_data_pins_mask);
-  }
-  gpio_put(handle->_enable_pin, 1);
-  sleep_us(1);
-  for (int i = 0; i < 8; i++) {
-    gpio_put(handle->_data_pins[i], (data >> i) & 0x01);
+_LCD_BUS_INLINE void _LCD_RAM_FUNC(_lcd_write_8_bits)(LCD_Handle *handle,
+                                                      uint8_t data) {
+  if (_LCD_HAS_RW(handle)) {
+    gpio_put(_LCD_RW_PIN(handle), 0);
+    _LCD_SLEEP_US(1);
+    gpio_set_dir_out_masked(_LCD_DATA_PINS_MASK(handle));
   }
-  sleep_us(1);
-  gpio_put(handle->_enable_pin, 0);
-  if (handle->_rw_pin != 255) {
-    sleep_us(1);
+  gpio_put(_LCD_EN_PIN(handle), 1);
+  _LCD_SLEEP_US(1);
+  _lcd_put_data_pins(handle, data, 8);
+  _LCD_SLEEP_US(1);
+  gpio_put(_LCD_EN_PIN(handle), 0);
+  _LCD_TRACE(handle, 0, data);
+  if (_LCD_HAS_RW(handle)) {
+    _LCD_SLEEP_US(1);
   } else {
-    sleep_us(100);
+    _lcd_delay_us(handle, 100);
   }
 }
 
@@ -797,23 +5604,23 @@ void _lcd_write_8_bits(LCD_Handle *handle, uint8_t data) {
  * @param handle Pointer to the LCD handle.
  * @param data 4-bit data nibble to be written to the LCD.
  */
-void _lcd_write_4_bits(LCD_Handle *handle, uint8_t data) {
-  if (handle->_rw_pin != 255) {
-    gpio_put(handle->_rw_pin, 0);
-    sleep_us(1);
-    gpio_set_dir_out_masked(handle->_data_pins_mask);
-  }
-  gpio_put(handle->_enable_pin, 1);
-  sleep_us(1);
-  for (int i = 0; i < 4; i++) {
-    gpio_put(handle->_data_pins[i], (data >> i) & 0x01);
+_LCD_BUS_INLINE void _LCD_RAM_FUNC(_lcd_write_4_bits)(LCD_Handle *handle,
+                                                      uint8_t data) {
+  if (_LCD_HAS_RW(handle)) {
+    gpio_put(_LCD_RW_PIN(handle), 0);
+    _LCD_SLEEP_US(1);
+    gpio_set_dir_out_masked(_LCD_DATA_PINS_MASK(handle));
   }
-  sleep_us(1);
-  gpio_put(handle->_enable_pin, 0);
-  if (handle->_rw_pin != 255) {
-    sleep_us(1);
+  gpio_put(_LCD_EN_PIN(handle), 1);
+  _LCD_SLEEP_US(1);
+  _lcd_put_data_pins(handle, data, 4);
+  _LCD_SLEEP_US(1);
+  gpio_put(_LCD_EN_PIN(handle), 0);
+  _LCD_TRACE(handle, LCD_TRACE_NIBBLE, data & 0x0F);
+  if (_LCD_HAS_RW(handle)) {
+    _LCD_SLEEP_US(1);
   } else {
-    sleep_us(100);
+    _lcd_delay_us(handle, 100);
   }
 }
 
@@ -826,49 +5633,94 @@ void _lcd_write_4_bits(LCD_Handle *handle, uint8_t data) {
  * @param handle Pointer to the LCD handle.
  * @return uint8_t The 8-bit data byte read from the LCD.
  */
-uint8_t _lcd_read_8_bits(LCD_Handle *handle) {
-  if (handle->_rw_pin == 255) {
+_LCD_BUS_INLINE uint8_t _LCD_RAM_FUNC(_lcd_read_8_bits)(LCD_Handle *handle) {
+  if (!_LCD_HAS_RW(handle)) {
+    return 255;
+  }
+  uint8_t data;
+  gpio_set_dir_in_masked(_LCD_DATA_PINS_MASK(handle));
+  gpio_put(_LCD_RW_PIN(handle), 1);
+  _LCD_SLEEP_US(1);
+  gpio_put(_LCD_EN_PIN(handle), 1);
+  _LCD_SLEEP_US(1);
+  data = _lcd_get_data_pins(handle, 8);
+  gpio_put(_LCD_EN_PIN(handle), 0);
+  _LCD_TRACE(handle, LCD_TRACE_READ, data);
+  _LCD_SLEEP_US(1);
+  return data;
+}
+
+/**
+ * @brief Reads an 8-bit byte from the LCD as two 4-bit nibbles.
+ *
+ * This function sets the data pins as inputs and raises the RW pin once, then
+ * toggles the ENABLE pin twice to read the high and the low nibble.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @return uint8_t The 8-bit data byte read from the LCD.
+ */
+_LCD_BUS_INLINE uint8_t _LCD_RAM_FUNC(_lcd_read_2x4_bits)(LCD_Handle *handle) {
+  if (!_LCD_HAS_RW(handle)) {
     return 255;
   }
   uint8_t data = 0;
-  gpio_set_dir_in_masked(handle->_data_pins_mask);
-  gpio_put(handle->_rw_pin, 1);
-  sleep_us(1);
-  gpio_put(handle->_enable_pin, 1);
-  sleep_us(1);
-  for (int i = 0; i < 8; i++) {
-    data |= gpio_get(handle->_data_pins[i]) << i;
+  gpio_set_dir_in_masked(_LCD_DATA_PINS_MASK(handle));
+  gpio_put(_LCD_RW_PIN(handle), 1);
+  _LCD_SLEEP_US(1);
+  for (int shift = 4; shift >= 0; shift -= 4) {
+    gpio_put(_LCD_EN_PIN(handle), 1);
+    _LCD_SLEEP_US(1);
+    const uint8_t nibble = _lcd_get_data_pins(handle, 4);
+    gpio_put(_LCD_EN_PIN(handle), 0);
+    _LCD_TRACE(handle, LCD_TRACE_READ | LCD_TRACE_NIBBLE, nibble);
+    _LCD_SLEEP_US(1);
+    data |= nibble << shift;
   }
-  gpio_put(handle->_enable_pin, 0);
-  sleep_us(1);
   return data;
 }
 
 /**
- * @brief Reads a 4-bit data nibble from the LCD.
- *
- * This function reads a 4-bit data nibble from the LCD by setting the data pins as inputs
- * and toggling the ENABLE pin. It also handles the RW pin if it is used.
+ * @brief Drives the data lines with the low bits of a value.
  *
  * @param handle Pointer to the LCD handle.
- * @return uint8_t The 4-bit data nibble read from the LCD.
+ * @param data Value to put on the data lines (bit 0 on data line 0).
+ * @param count Number of data lines to drive (4 or 8).
  */
-uint8_t _lcd_read_4_bits(LCD_Handle *handle) {
-  if (handle->_rw_pin == 255) {
-    return 15;
+_LCD_BUS_INLINE void _LCD_RAM_FUNC(_lcd_put_data_pins)(LCD_Handle *handle,
+                                                       uint8_t data,
+                                                       int count) {
+#if LCD_CONFIG_PINS
+  (void)handle;
+  (void)count;
+  gpio_put_masked(_LCD_DATA_MASK, _LCD_SPREAD(data));
+#else
+  for (int i = 0; i < count; i++) {
+    gpio_put(handle->_data_pins[i], (data >> i) & 0x01);
   }
+#endif
+}
+
+/**
+ * @brief Samples the data lines.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param count Number of data lines to sample (4 or 8).
+ * @return uint8_t The sampled value (data line 0 in bit 0).
+ */
+_LCD_BUS_INLINE uint8_t _LCD_RAM_FUNC(_lcd_get_data_pins)(LCD_Handle *handle,
+                                                          int count) {
+#if LCD_CONFIG_PINS
+  (void)handle;
+  (void)count;
+  const uint32_t all = gpio_get_all();
+  return _LCD_GATHER(all);
+#else
   uint8_t data = 0;
-  gpio_set_dir_in_masked(handle->_data_pins_mask);
-  gpio_put(handle->_rw_pin, 1);
-  sleep_us(1);
-  gpio_put(handle->_enable_pin, 1);
-  sleep_us(1);
-  for (int i = 0; i < 4; i++) {
+  for (int i = 0; i < count; i++) {
     data |= gpio_get(handle->_data_pins[i]) << i;
   }
-  gpio_put(handle->_enable_pin, 0);
-  sleep_us(1);
   return data;
+#endif
 }
 
 /**
@@ -881,4 +5733,65 @@ uint8_t _lcd_read_4_bits(LCD_Handle *handle) {
  * @param handle Pointer to the LCD handle.
  * @return true if the LCD is busy, false otherwise.
  */
-bool _lcd_busy(LCD_Handle *handle) { return _lcd_read_command(handle) & 0x80; }
\ No newline at end of file
+_LCD_BUS_INLINE bool _LCD_RAM_FUNC(_lcd_busy)(LCD_Handle *handle) {
+  _LCD_STATS_ADD(handle, busy_polls, 1);
+  return _lcd_read_command(handle) & 0x80;
+}
+
+/**
+ * @brief Waits until the LCD is ready to accept the next transfer.
+ *
+ * This function polls the busy flag if the RW pin is used. Polling gives up
+ * after LCD_BUSY_TIMEOUT_US so a disconnected display can't hang the caller.
+ *
+ * @param handle Pointer to the LCD handle.
+ */
+_LCD_BUS_INLINE void _LCD_RAM_FUNC(_lcd_wait_ready)(LCD_Handle *handle) {
+  if (!_LCD_HAS_RW(handle)) {
+    return;
+  }
+  const uint32_t start = time_us_32();
+  while (_lcd_busy(handle)) {
+    if (time_us_32() - start >= LCD_BUSY_TIMEOUT_US) {
+      _LCD_STATS_ADD(handle, busy_timeouts, 1);
+      break;
+    }
+    _LCD_SLEEP_US(3);
+  }
+  _LCD_STATS_ADD(handle, wait_us, time_us_32() - start);
+}
+
+/**
+ * @brief Waits a fixed time for the LCD to execute an instruction.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param us Time to wait in microseconds.
+ */
+void _LCD_RAM_FUNC(_lcd_delay_us)(LCD_Handle *handle, uint32_t us) {
+  _LCD_SLEEP_US(us);
+  _LCD_STATS_ADD(handle, wait_us, us);
+}
+
+#if LCD_ENABLE_STATS
+/**
+ * @brief Records the latency of a public API call in its histogram.
+ *
+ * Calls made from within another API call only leave their nesting level.
+ *
+ * @param handle Pointer to the LCD handle.
+ * @param api Public API call that finished.
+ * @param start Value of time_us_32() when the call started.
+ */
+void _lcd_stats_record_api(LCD_Handle *handle, LCD_Api api, uint32_t start) {
+  if (--handle->_api_depth > 0) {
+    return;
+  }
+  const uint32_t elapsed = time_us_32() - start;
+  uint32_t bucket = 31 - __builtin_clz(elapsed | 1);
+  if (bucket >= LCD_STATS_HISTOGRAM_BUCKETS) {
+    bucket = LCD_STATS_HISTOGRAM_BUCKETS - 1;
+  }
+  handle->_stats.api_calls[api]++;
+  handle->_stats.api_latency[api][bucket]++;
+}
+#endif
\ No newline at end of file
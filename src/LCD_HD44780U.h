@@ -62,12 +62,294 @@
 #define LCD_5x10DOTS 0x04
 #define LCD_5x8DOTS 0x00
 
+// ########################################################################## //
+//                                                                            //
+//                        Compile-time configuration                          //
+//                                                                            //
+// ########################################################################## //
+
+// These options change the layout of LCD_Handle, so they have to be defined
+// for the whole target (target_compile_definitions), not per source file.
+// They can also be collected in a header passed as LCD_CONFIG_FILE, e.g.
+// -DLCD_CONFIG_FILE=\"lcd_config.h\".
+#ifdef LCD_CONFIG_FILE
+#include LCD_CONFIG_FILE
+#endif
+
+// Fixed wiring for single-display builds. Every option left at its default
+// is decided at run time from the arguments of lcd_init_*(), every fixed one
+// lets the compiler drop the run-time checks and the unused bus code.
+// lcd_init_*() returns NULL if its arguments don't match the fixed wiring.
+
+// Data bus width: 4 or 8 bits, 0 to decide at run time.
+#ifndef LCD_CONFIG_BUS_WIDTH
+#define LCD_CONFIG_BUS_WIDTH 0
+#endif
+
+// R/W pin: 1 if connected, 0 if grounded, -1 to decide at run time.
+#ifndef LCD_CONFIG_HAS_RW
+#define LCD_CONFIG_HAS_RW -1
+#endif
+
+// Fixed GPIO pins: 1 to take them from LCD_CONFIG_PIN_RS, LCD_CONFIG_PIN_RW
+// (if LCD_CONFIG_HAS_RW is 1), LCD_CONFIG_PIN_EN and LCD_CONFIG_PIN_D0-D7
+// (LCD_CONFIG_PIN_D4-D7 for a 4-bit bus), 0 to decide at run time. Requires
+// LCD_CONFIG_BUS_WIDTH and LCD_CONFIG_HAS_RW to be fixed as well.
+#ifndef LCD_CONFIG_PINS
+#define LCD_CONFIG_PINS 0
+#endif
+
+// Place the transfer and flush routines in SRAM instead of flash (0 or 1).
+// Bus timing then no longer depends on XIP cache misses and
+// lcd_flush_flash_safe() becomes available.
+#ifndef LCD_CONFIG_RUN_FROM_RAM
+#define LCD_CONFIG_RUN_FROM_RAM 0
+#endif
+
+#if LCD_CONFIG_BUS_WIDTH != 0 && LCD_CONFIG_BUS_WIDTH != 4 && \
+    LCD_CONFIG_BUS_WIDTH != 8
+#error "LCD_CONFIG_BUS_WIDTH must be 0, 4 or 8"
+#endif
+#if LCD_CONFIG_PINS && (LCD_CONFIG_BUS_WIDTH == 0 || LCD_CONFIG_HAS_RW < 0)
+#error "LCD_CONFIG_PINS requires LCD_CONFIG_BUS_WIDTH and LCD_CONFIG_HAS_RW"
+#endif
+
+// Enable per-handle performance counters and latency histograms (0 or 1).
+#ifndef LCD_ENABLE_STATS
+#define LCD_ENABLE_STATS 0
+#endif
+
+// Number of log2 latency histogram buckets kept per public API call.
+// Bucket n counts calls that took [2^n, 2^(n+1)) microseconds, the last
+// bucket also counts everything slower.
+#ifndef LCD_STATS_HISTOGRAM_BUCKETS
+#define LCD_STATS_HISTOGRAM_BUCKETS 16
+#endif
+
+// Enable the bus transaction trace ring buffer (0 or 1).
+#ifndef LCD_ENABLE_TRACE
+#define LCD_ENABLE_TRACE 0
+#endif
+
+// Number of transfers kept in the trace ring buffer (power of two).
+#ifndef LCD_TRACE_DEPTH
+#define LCD_TRACE_DEPTH 256
+#endif
+
+#if (LCD_TRACE_DEPTH & (LCD_TRACE_DEPTH - 1)) != 0
+#error "LCD_TRACE_DEPTH must be a power of two"
+#endif
+
+// Maximum time to poll the busy flag before giving up (R/W pin only).
+#ifndef LCD_BUSY_TIMEOUT_US
+#define LCD_BUSY_TIMEOUT_US 10000
+#endif
+
+// Maximum number of cells of the pixel canvas (8 bytes each in the handle).
+#ifndef LCD_CANVAS_MAX_CELLS
+#define LCD_CANVAS_MAX_CELLS 16
+#endif
+
+// Number of sprites of a handle.
+#ifndef LCD_MAX_SPRITES
+#define LCD_MAX_SPRITES 4
+#endif
+
+// Number of distinct characters drawn from CGRAM glyphs that the frame buffer
+// can hold, lcd_flush() shows as many of them as there are free slots.
+#ifndef LCD_MAX_PLANNED_GLYPHS
+#define LCD_MAX_PLANNED_GLYPHS 16
+#endif
+#if LCD_MAX_PLANNED_GLYPHS < 1 || LCD_MAX_PLANNED_GLYPHS > 32
+#error "LCD_MAX_PLANNED_GLYPHS must be between 1 and 32"
+#endif
+
+// Blink period of cells with LCD_ATTR_BLINK, hidden for the second half.
+#ifndef LCD_BLINK_PERIOD_MS
+#define LCD_BLINK_PERIOD_MS 1000
+#endif
+
 // ########################################################################## //
 //                                                                            //
 //                            Structure definition                            //
 //                                                                            //
 // ########################################################################## //
 
+// Public API calls tracked by the latency histograms.
+typedef enum LCD_Api {
+  LCD_API_CLEAR,
+  LCD_API_HOME,
+  LCD_API_DISPLAY_OFF,
+  LCD_API_DISPLAY_ON,
+  LCD_API_BLINK_OFF,
+  LCD_API_BLINK_ON,
+  LCD_API_CURSOR_OFF,
+  LCD_API_CURSOR_ON,
+  LCD_API_SCROLL_DISPLAY_LEFT,
+  LCD_API_SCROLL_DISPLAY_RIGHT,
+  LCD_API_LEFT_TO_RIGHT,
+  LCD_API_RIGHT_TO_LEFT,
+  LCD_API_AUTOSCROLL_OFF,
+  LCD_API_AUTOSCROLL_ON,
+  LCD_API_SET_CURSOR,
+  LCD_API_WRITE_CHAR,
+  LCD_API_WRITE_STRING,
+  LCD_API_WRITE_CHAR_AT,
+  LCD_API_WRITE_STRING_AT,
+  LCD_API_CREATE_CHAR,
+  LCD_API_FLUSH,
+  LCD_API_READ_SCREEN,
+  LCD_API_READ_GLYPHS,
+  LCD_API_SCRUB,
+  LCD_API_COMMIT,
+  LCD_API_REPLAY,
+  LCD_API_WRITE_INT_AT,
+  LCD_API_WRITE_FIXED_AT,
+  LCD_API_WRITE_BIG_AT,
+  LCD_API_WRITE_BIG_NUMBER_AT,
+  LCD_API_BAR_AT,
+  LCD_API_PROGRESS_AT,
+  LCD_API_SPARKLINE_PUSH,
+  LCD_API_CANVAS_FLUSH,
+  LCD_API_SPRITE_UPDATE,
+  LCD_API_TICKER_STEP,
+  LCD_API_REPLAY_FIELD,
+  LCD_API_COUNT
+} LCD_Api;
+
+// Snapshot of the performance counters returned by lcd_get_stats().
+typedef struct LCD_Stats {
+  // Number of instruction bytes sent to the controller
+  uint32_t commands;
+  // Number of data bytes sent to the controller
+  uint32_t data_bytes;
+  // Number of busy flag reads
+  uint32_t busy_polls;
+  // Number of busy flag polls that hit LCD_BUSY_TIMEOUT_US
+  uint32_t busy_timeouts;
+  // Number of characters rewritten by lcd_scrub()
+  uint32_t scrub_repairs;
+  // Number of times lcd_scrub() initialized the controller again
+  uint32_t scrub_restores;
+  // Time spent waiting for the controller (busy flag polling and fixed
+  // execution delays), in microseconds
+  uint64_t wait_us;
+  // Time spent driving the bus, waiting excluded, in microseconds
+  uint64_t bus_us;
+  // Number of calls of every public API function
+  uint32_t api_calls[LCD_API_COUNT];
+  // log2 latency histogram of every public API function
+  uint32_t api_latency[LCD_API_COUNT][LCD_STATS_HISTOGRAM_BUCKETS];
+} LCD_Stats;
+
+// lcd_scrub() result after the controller was initialized again
+#define LCD_SCRUB_RESTORED (-1)
+
+// Recorded streams (see lcd_record_begin()) start with the bus width they were
+// recorded for. In 4-bit streams every nibble sent is one byte, LCD_STREAM_RS
+// plus the nibble (high nibble first); in 8-bit streams every byte sent is a
+// flag byte (LCD_STREAM_RS or 0) followed by the byte. A byte with
+// LCD_STREAM_WAIT set instead waits for its low 7 bits times
+// LCD_STREAM_WAIT_UNIT_US microseconds.
+#define LCD_STREAM_4BIT 0x04
+#define LCD_STREAM_8BIT 0x08
+#define LCD_STREAM_RS 0x10
+#define LCD_STREAM_WAIT 0x80
+#define LCD_STREAM_WAIT_UNIT_US 64
+
+// flags for lcd_write_int_at() and lcd_write_fixed_at()
+#define LCD_NUM_LEFT 0x01   // left-align (default is right-aligned)
+#define LCD_NUM_ZEROS 0x02  // pad with leading zeros instead of spaces
+#define LCD_NUM_PLUS 0x04   // show '+' in front of positive numbers
+
+// attributes for lcd_set_attributes_at()
+#define LCD_ATTR_BLINK 0x01    // alternate between the character and a space
+#define LCD_ATTR_INVERSE 0x02  // light pixels on a dark cell
+
+// character sets for lcd_set_charset()
+#define LCD_CHARSET_RAW 0
+#define LCD_CHARSET_A00 1
+#define LCD_CHARSET_A02 2
+
+// Field of a stream generated by tools/lcd_screenc.py, see lcd_stream_patch().
+typedef struct LCD_StreamField {
+  // Offset of the first character of the field in the stream
+  uint16_t offset;
+  // Column of the first character on the display
+  uint8_t col;
+  // Row of the field on the display
+  uint8_t row;
+  // Number of characters
+  uint8_t width;
+} LCD_StreamField;
+
+// Sprite of the sprite engine, see lcd_sprite_move().
+typedef struct LCD_Sprite {
+  // Pixel rows, 5 bits each
+  uint8_t rows[8];
+  // Pixel position of the top left corner
+  int16_t x;
+  int16_t y;
+  // Drawn by lcd_sprite_update()
+  bool visible;
+} LCD_Sprite;
+
+// Animation of a custom character, see lcd_animate().
+typedef struct LCD_Animation {
+  // Frames of 8 pixel rows each (not copied)
+  const uint8_t *frames;
+  // Time each frame is shown
+  uint32_t period_us;
+  // Time the next frame is due, in microseconds since boot
+  uint64_t due_us;
+  // Number of frames, 0 if the character isn't animated
+  volatile uint8_t count;
+  // Frame shown now
+  uint8_t frame;
+} LCD_Animation;
+
+// Window over the frame buffer, see lcd_window_open(). The fields are set up
+// by the library.
+typedef struct LCD_Window {
+  // Character codes of the cells followed by their attributes, row-major
+  // (LCD_WINDOW_SIZE bytes provided by the caller, not copied)
+  uint8_t *cells;
+  // Position of the top left cell on the display
+  uint8_t col;
+  uint8_t row;
+  // Size in cells
+  uint8_t width;
+  uint8_t height;
+  // Stacking order, higher windows hide lower ones
+  uint8_t z;
+  // Cells changed since the last flush, in window coordinates (none if
+  // dirty_left > dirty_right)
+  uint8_t dirty_left;
+  uint8_t dirty_top;
+  uint8_t dirty_right;
+  uint8_t dirty_bottom;
+  // Next lower open window
+  struct LCD_Window *next;
+} LCD_Window;
+
+// Number of bytes of the cell buffer of a window of the given size.
+#define LCD_WINDOW_SIZE(width, height) (2 * (size_t)(width) * (size_t)(height))
+
+// flags for trace entries
+#define LCD_TRACE_RS 0x01
+#define LCD_TRACE_READ 0x02
+#define LCD_TRACE_NIBBLE 0x04
+
+// One bus transfer recorded in the trace ring buffer.
+typedef struct LCD_TraceEntry {
+  // Value of time_us_32() when the ENABLE pulse ended
+  uint32_t time_us;
+  // Combination of LCD_TRACE_RS, LCD_TRACE_READ and LCD_TRACE_NIBBLE
+  uint8_t flags;
+  // Byte or nibble (low 4 bits) transferred
+  uint8_t value;
+} LCD_TraceEntry;
+
 // Define a structure for the HD44780U LCD controller.
 typedef struct LCD_HD44780U {
   // Pin to control Register Select (RS):
@@ -89,13 +371,170 @@ typedef struct LCD_HD44780U {
   uint8_t _displaycontrol;
   // LCD display mode settings
   uint8_t _displaymode;
+  // Display control settings the controller holds (0xFF if unknown)
+  uint8_t _sent_displaycontrol;
+  // Entry mode the controller holds (0xFF if unknown), _displaymode is sent
+  // before the next data write if it differs
+  uint8_t _sent_displaymode;
+  // Nesting depth of lcd_begin() transactions
+  uint8_t _transaction_depth;
   // Number of lines on the LCD:
   // Typically 1, 2, or 4 depending on the specific LCD module.
   uint8_t _numlines;
   // Array to store the row offsets
   uint8_t _row_offsets[4];
+  // Number of columns on the LCD
+  uint8_t _cols;
+  // Address counter as last set by this library (DDRAM or CGRAM address)
+  uint8_t _address;
+  // true if the address counter points into CGRAM
+  bool _cgram_selected;
+  // Display shift in positions to the right (0 to line length - 1)
+  uint8_t _shift;
+  // true if characters were written to DDRAM outside the visible area
+  bool _offscreen_dirty;
+  // true if the handle lives in caller-provided storage (not freed)
+  bool _static;
+  // Next step of the initialization sequence (see lcd_init_poll())
+  uint8_t _init_state;
+  // Uptime in microseconds before which the next step must not run
+  uint64_t _init_deadline;
+  // alarm_id_t of the alarm started by lcd_init_async(), 0 if none
+  int32_t _init_alarm;
+  // Next character checked by lcd_scrub(): visible cells, then CGRAM rows
+  uint16_t _scrub_position;
+  // Buffer of the stream recorded by lcd_record_begin(), NULL if none
+  uint8_t *_record;
+  // Size of the _record buffer in bytes
+  size_t _record_size;
+  // Bytes recorded so far, larger than _record_size if it didn't fit
+  size_t _record_length;
+  // Shadow copy of the characters on the display, one byte per cell
+  // (row-major, _cols * _numlines bytes, stored right after the handle)
+  uint8_t *_shadow;
+  // Characters the display should show after the next lcd_flush()
+  // (same layout, stored right after the shadow)
+  uint8_t *_frame;
+  // LCD_ATTR_* of every cell (same layout, stored right after the frame)
+  uint8_t *_attributes;
+  // Number of cells with attributes
+  uint16_t _attribute_cells;
+  // true while cells are redrawn from the frame buffer or the shadow copy,
+  // data writes don't replace the frame buffer then
+  bool _redrawing;
+  // Open windows composed into the frame buffer, topmost first
+  LCD_Window *_windows;
+  // Shadow copy of the CGRAM (8 custom characters, 8 rows each)
+  uint8_t _cgram[64];
+  // Bitmask of custom characters whose _cgram rows are known
+  uint8_t _cgram_valid;
+  // Translation of text to character codes (LCD_CHARSET_*)
+  uint8_t _charset;
+  // Bitmask of custom characters created by lcd_create_char(), never reused
+  // by the glyph cache
+  uint8_t _glyph_reserved;
+  // Next CGRAM slot tried by the glyph cache
+  uint8_t _glyph_next;
+  // Code point of the glyph cached in every CGRAM slot, 0 if none
+  uint16_t _glyph_codepoints[8];
+  // Characters of the frame buffer that need a glyph, 0 if unused. Their
+  // cells hold an index into these tables until lcd_flush() plans the screen.
+  uint16_t _plan_codepoints[LCD_MAX_PLANNED_GLYPHS];
+  // ROM character shown instead if the glyph doesn't get a slot
+  uint8_t _plan_fallbacks[LCD_MAX_PLANNED_GLYPHS];
+  // Custom character given to the glyph by the last plan, 0xFF if none
+  uint8_t _plan_codes[LCD_MAX_PLANNED_GLYPHS];
+  // false if characters were added to the tables since the last plan
+  bool _plan_valid;
+  // _glyph_reserved when the last plan was made
+  uint8_t _plan_reserved;
+  // Height of the big font in rows, 0 before lcd_big_init()
+  uint8_t _big_height;
+  // First custom character of the big font
+  uint8_t _big_slot;
+  // Set by lcd_bar_init()
+  bool _bar_ready;
+  // First custom character of the bar graphs
+  uint8_t _bar_slot;
+  // Width of the sparkline in cells, 0 if there is none
+  uint8_t _sparkline_cells;
+  // First custom character of the sparkline
+  uint8_t _sparkline_slot;
+  // Column heights (0-8) of the sparkline, oldest sample first
+  uint8_t _sparkline_levels[40];
+  // Size of the pixel canvas in cells, 0 if there is none
+  uint8_t _canvas_cols;
+  uint8_t _canvas_rows;
+  // Position of the top left cell of the canvas
+  uint8_t _canvas_col;
+  uint8_t _canvas_row;
+  // First custom character of the canvas
+  uint8_t _canvas_slot;
+  // Pixel rows of every cell of the canvas, row-major
+  uint8_t _canvas_pixels[LCD_CANVAS_MAX_CELLS][8];
+  // Bitmask of the pixel rows of every cell changed since the last flush
+  uint8_t _canvas_dirty[LCD_CANVAS_MAX_CELLS];
+  // Character code shown in every cell of the canvas by the last flush
+  uint8_t _canvas_codes[LCD_CANVAS_MAX_CELLS];
+  // Set by lcd_sprite_init()
+  bool _sprite_ready;
+  // First custom character of the sprite engine
+  uint8_t _sprite_slot;
+  LCD_Sprite _sprites[LCD_MAX_SPRITES];
+  // Cell shown with every custom character of the engine, 0xFF if none
+  uint8_t _sprite_cells[8];
+  // Character of that cell without sprites
+  uint8_t _sprite_backgrounds[8];
+  // Bitmask of custom characters whose background is an index into
+  // _plan_codepoints
+  uint8_t _sprite_planned;
+  // Width of the smooth scrolling ticker in cells, 0 if there is none
+  uint8_t _ticker_cells;
+  // First custom character of the ticker
+  uint8_t _ticker_slot;
+  // Text of the ticker (not copied) and its length
+  const char *_ticker_text;
+  uint16_t _ticker_length;
+  // Pixel position of the ticker in the text, 0 shows it blank
+  uint16_t _ticker_position;
+  // Animations of the custom characters, see lcd_animate()
+  LCD_Animation _animations[8];
+  // alarm_id_t of the animation alarm, 0 if it isn't running
+  volatile int32_t _animation_alarm;
+  // Time the animation alarm fires next, in microseconds since boot
+  volatile uint64_t _animation_due;
+  // Transfers (or instructions with their wait) in progress, the animation
+  // alarm doesn't interrupt them
+  volatile uint8_t _bus_depth;
+#if LCD_ENABLE_STATS
+  // Performance counters
+  LCD_Stats _stats;
+  // Nesting depth of the public API calls being measured
+  uint8_t _api_depth;
+#endif
+#if LCD_ENABLE_TRACE
+  // Bus transaction trace ring buffer
+  LCD_TraceEntry _trace[LCD_TRACE_DEPTH];
+  // Total number of transfers recorded
+  uint32_t _trace_count;
+#endif
 } LCD_Handle;
 
+// Number of bytes of per-cell state kept for a display of the given size.
+#define LCD_SHADOW_SIZE(cols, rows) (3 * (size_t)(cols) * (size_t)(rows))
+
+// Number of bytes of storage needed by lcd_init_*_static() for a display of
+// the given size.
+#define LCD_STORAGE_SIZE(cols, rows) \
+  (sizeof(LCD_Handle) + LCD_SHADOW_SIZE(cols, rows))
+
+// Defines a suitably aligned storage for lcd_init_*_static(), e.g.
+//   static LCD_STORAGE(lcd_storage, 16, 2);
+//   LCD_Handle *lcd = lcd_init_4bit_static(lcd_storage, sizeof(lcd_storage),
+//                                          16, 2, ...);
+#define LCD_STORAGE(name, cols, rows) \
+  _Alignas(LCD_Handle) uint8_t name[LCD_STORAGE_SIZE(cols, rows)]
+
 // ########################################################################## //
 //                                                                            //
 //                        Public functions definition                         //
@@ -110,6 +549,41 @@ LCD_Handle *lcd_init_4bit(uint8_t cols, uint8_t rows, uint8_t charsize,
                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d4,
                           uint8_t d5, uint8_t d6, uint8_t d7);
 
+LCD_Handle *lcd_init_8bit_static(void *storage, size_t storage_size,
+                                 uint8_t cols, uint8_t rows, uint8_t charsize,
+                                 uint8_t rs, uint8_t rw, uint8_t enable,
+                                 uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
+                                 uint8_t d4, uint8_t d5, uint8_t d6,
+                                 uint8_t d7);
+LCD_Handle *lcd_init_4bit_static(void *storage, size_t storage_size,
+                                 uint8_t cols, uint8_t rows, uint8_t charsize,
+                                 uint8_t rs, uint8_t rw, uint8_t enable,
+                                 uint8_t d4, uint8_t d5, uint8_t d6,
+                                 uint8_t d7);
+
+LCD_Handle *lcd_start_8bit(uint8_t cols, uint8_t rows, uint8_t charsize,
+                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d0,
+                           uint8_t d1, uint8_t d2, uint8_t d3, uint8_t d4,
+                           uint8_t d5, uint8_t d6, uint8_t d7);
+LCD_Handle *lcd_start_4bit(uint8_t cols, uint8_t rows, uint8_t charsize,
+                           uint8_t rs, uint8_t rw, uint8_t enable, uint8_t d4,
+                           uint8_t d5, uint8_t d6, uint8_t d7);
+LCD_Handle *lcd_start_8bit_static(void *storage, size_t storage_size,
+                                  uint8_t cols, uint8_t rows, uint8_t charsize,
+                                  uint8_t rs, uint8_t rw, uint8_t enable,
+                                  uint8_t d0, uint8_t d1, uint8_t d2,
+                                  uint8_t d3, uint8_t d4, uint8_t d5,
+                                  uint8_t d6, uint8_t d7);
+LCD_Handle *lcd_start_4bit_static(void *storage, size_t storage_size,
+                                  uint8_t cols, uint8_t rows, uint8_t charsize,
+                                  uint8_t rs, uint8_t rw, uint8_t enable,
+                                  uint8_t d4, uint8_t d5, uint8_t d6,
+                                  uint8_t d7);
+bool lcd_init_poll(LCD_Handle *handle);
+bool lcd_init_async(LCD_Handle *handle);
+bool lcd_is_ready(LCD_Handle *handle);
+bool lcd_attach(LCD_Handle *handle);
+
 LCD_Handle *lcd_deinit(LCD_Handle *handle);
 
 void lcd_clear(LCD_Handle *handle);
@@ -128,11 +602,110 @@ void lcd_right_to_left(LCD_Handle *handle);
 void lcd_autoscroll_off(LCD_Handle *handle);
 void lcd_autoscroll_on(LCD_Handle *handle);
 
+void lcd_begin(LCD_Handle *handle);
+void lcd_commit(LCD_Handle *handle);
+
 void lcd_set_cursor(LCD_Handle *handle, uint8_t col, uint8_t row);
 void lcd_write_char(LCD_Handle *handle, char symbol);
 void lcd_write_string(LCD_Handle *handle, char *text);
 void lcd_write_char_at(LCD_Handle *handle, char symbol, uint8_t col, uint8_t row);
 void lcd_write_string_at(LCD_Handle *handle, char *text, uint8_t col, uint8_t row);
+void lcd_write_int_at(LCD_Handle *handle, int32_t value, uint8_t width,
+                      uint8_t flags, uint8_t col, uint8_t row);
+void lcd_write_fixed_at(LCD_Handle *handle, int32_t value, uint8_t decimals,
+                        uint8_t width, uint8_t flags, uint8_t col,
+                        uint8_t row);
+
+bool lcd_big_init(LCD_Handle *handle, uint8_t height, uint8_t first_slot);
+void lcd_write_big_at(LCD_Handle *handle, const char *text, uint8_t col,
+                      uint8_t row);
+void lcd_write_big_number_at(LCD_Handle *handle, int32_t value,
+                             uint8_t decimals, uint8_t width, uint8_t flags,
+                             uint8_t col, uint8_t row);
+
+bool lcd_bar_init(LCD_Handle *handle, uint8_t first_slot);
+void lcd_bar_at(LCD_Handle *handle, uint16_t value, uint16_t max,
+                uint8_t width, uint8_t col, uint8_t row);
+void lcd_progress_at(LCD_Handle *handle, uint8_t percent, uint8_t width,
+                     uint8_t col, uint8_t row);
+
+bool lcd_sparkline_init(LCD_Handle *handle, uint8_t cells, uint8_t first_slot,
+                        uint8_t col, uint8_t row);
+void lcd_sparkline_push(LCD_Handle *handle, uint16_t value, uint16_t max);
+
+bool lcd_canvas_init(LCD_Handle *handle, uint8_t cols, uint8_t rows,
+                     uint8_t first_slot, uint8_t col, uint8_t row);
+void lcd_canvas_clear(LCD_Handle *handle);
+void lcd_canvas_pixel(LCD_Handle *handle, int16_t x, int16_t y, bool on);
+void lcd_canvas_line(LCD_Handle *handle, int16_t x0, int16_t y0, int16_t x1,
+                     int16_t y1, bool on);
+void lcd_canvas_rect(LCD_Handle *handle, int16_t x, int16_t y, uint8_t width,
+                     uint8_t height, bool filled, bool on);
+void lcd_canvas_blit(LCD_Handle *handle, int16_t x, int16_t y, uint8_t width,
+                     uint8_t height, const uint8_t *bitmap);
+bool lcd_canvas_flush(LCD_Handle *handle);
+
+bool lcd_sprite_init(LCD_Handle *handle, uint8_t first_slot);
+void lcd_sprite_set(LCD_Handle *handle, uint8_t id, const uint8_t *rows);
+void lcd_sprite_move(LCD_Handle *handle, uint8_t id, int16_t x, int16_t y);
+void lcd_sprite_hide(LCD_Handle *handle, uint8_t id);
+bool lcd_sprite_update(LCD_Handle *handle);
+
+bool lcd_ticker_init(LCD_Handle *handle, uint8_t cells, uint8_t first_slot,
+                     uint8_t col, uint8_t row);
+void lcd_ticker_text(LCD_Handle *handle, const char *text);
+void lcd_ticker_step(LCD_Handle *handle);
+
+bool lcd_animate(LCD_Handle *handle, uint8_t slot, const uint8_t *frames,
+                 uint8_t count, uint32_t period_ms);
+void lcd_animate_stop(LCD_Handle *handle, uint8_t slot);
+
+void lcd_set_charset(LCD_Handle *handle, uint8_t charset);
 void lcd_create_char(LCD_Handle *handle, uint8_t num, uint8_t *data);
 
+void lcd_buffer_clear(LCD_Handle *handle);
+void lcd_buffer_char_at(LCD_Handle *handle, char symbol, uint8_t col,
+                        uint8_t row);
+void lcd_buffer_string_at(LCD_Handle *handle, const char *text, uint8_t col,
+                          uint8_t row);
+void lcd_set_attributes_at(LCD_Handle *handle, uint8_t attributes,
+                           uint8_t width, uint8_t col, uint8_t row);
+
+bool lcd_window_open(LCD_Handle *handle, LCD_Window *window, uint8_t *cells,
+                     uint8_t col, uint8_t row, uint8_t width, uint8_t height,
+                     uint8_t z);
+void lcd_window_close(LCD_Handle *handle, LCD_Window *window);
+void lcd_window_clear(LCD_Handle *handle, LCD_Window *window);
+void lcd_window_char_at(LCD_Handle *handle, LCD_Window *window, char symbol,
+                        uint8_t col, uint8_t row);
+void lcd_window_string_at(LCD_Handle *handle, LCD_Window *window,
+                          const char *text, uint8_t col, uint8_t row);
+void lcd_window_set_attributes_at(LCD_Handle *handle, LCD_Window *window,
+                                  uint8_t attributes, uint8_t width,
+                                  uint8_t col, uint8_t row);
+
+void lcd_flush(LCD_Handle *handle);
+#if LCD_CONFIG_RUN_FROM_RAM
+void lcd_flush_flash_safe(LCD_Handle *handle);
+#endif
+
+bool lcd_read_screen(LCD_Handle *handle, char *buffer, size_t size);
+bool lcd_read_glyphs(LCD_Handle *handle, uint8_t *buffer, size_t size);
+
+int lcd_scrub(LCD_Handle *handle, uint8_t budget);
+
+bool lcd_record_begin(LCD_Handle *handle, uint8_t *buffer, size_t size);
+size_t lcd_record_end(LCD_Handle *handle);
+bool lcd_replay(LCD_Handle *handle, const uint8_t *stream, size_t length);
+bool lcd_stream_patch(uint8_t *stream, size_t length,
+                      const LCD_StreamField *field, const char *text);
+bool lcd_replay_field(LCD_Handle *handle, const uint8_t *stream, size_t length,
+                      const LCD_StreamField *field);
+
+bool lcd_get_stats(LCD_Handle *handle, LCD_Stats *stats);
+void lcd_reset_stats(LCD_Handle *handle);
+
+void lcd_trace_dump(LCD_Handle *handle);
+void lcd_trace_clear(LCD_Handle *handle);
+
 #endif
\ No newline at end of file
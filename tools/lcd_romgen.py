@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2024 Jozef Kromka <jozef.kromka22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+#
+"""Generate the UTF-8 translation tables of LCD_HD44780U.c.
+
+Usage: lcd_romgen.py [--update src/LCD_HD44780U.c]
+
+Prints the tables, or replaces them in the given source file between the
+"BEGIN lcd_romgen.py" and "END lcd_romgen.py" lines. The tables map Unicode
+code points to the character ROM codes of the A00 (Japanese) and A02
+(European) variants of the HD44780, to bitmaps for characters that are drawn
+into CGRAM when the ROM lacks them, and to ASCII transliterations used when
+no CGRAM slot is free. ASCII and the half-width katakana block are mapped by
+LCD_HD44780U.c itself.
+"""
+
+import argparse
+import sys
+import unicodedata
+
+# Characters of the A00 ROM outside ASCII and the half-width katakana block.
+ROM_A00 = {
+    "¥": 0x5C,  # YEN SIGN replaces the backslash
+    "→": 0x7E, "←": 0x7F,
+    "。": 0xA1, "「": 0xA2, "」": 0xA3, "、": 0xA4,
+    "・": 0xA5, "ー": 0xB0,
+    "°": 0xDF,  # the handakuten doubles as the degree sign
+    "α": 0xE0, "ä": 0xE1, "β": 0xE2, "ß": 0xE2,
+    "ε": 0xE3, "μ": 0xE4, "µ": 0xE4, "σ": 0xE5,
+    "ρ": 0xE6, "√": 0xE8, "¢": 0xEC, "£": 0xED,
+    "ñ": 0xEE, "ö": 0xEF, "θ": 0xF2, "∞": 0xF3,
+    "Ω": 0xF4, "Ω": 0xF4, "ü": 0xF5, "Σ": 0xF6,
+    "π": 0xF7, "千": 0xFA, "万": 0xFB, "円": 0xFC,
+    "÷": 0xFD, "█": 0xFF,
+}
+
+# Characters of the A02 ROM outside ASCII. 0xA0-0xFF follow ISO 8859-1
+# except for the codes left out here.
+ROM_A02 = {
+    "▶": 0x10, "◀": 0x11, "“": 0x12, "”": 0x13,
+    "↑": 0x18, "↓": 0x19, "→": 0x1A, "←": 0x1B,
+    "≤": 0x1C, "≥": 0x1D, "▲": 0x1E, "▼": 0x1F,
+    "⌂": 0x7F,
+}
+ROM_A02.update({chr(code): code for code in range(0xA0, 0x100)
+                if code not in (0xA8, 0xAC, 0xAD, 0xAF, 0xB4, 0xB8, 0xD8,
+                                0xF8)})
+
+# Bitmaps drawn into CGRAM for characters missing from the ROM, 5 pixels per
+# row, the last row is left free for the cursor where possible.
+GLYPHS = {
+    "\\": ["#....", "#....", ".#...", "..#..", "...#.", "....#", "....#",
+           "....."],
+    "~": [".....", ".....", ".#...", "#.#.#", "...#.", ".....", ".....",
+          "....."],
+    "Ä": [".#.#.", ".....", ".###.", "#...#", "#####", "#...#", "#...#",
+               "....."],
+    "Ç": [".###.", "#...#", "#....", "#....", "#...#", ".###.", "..#..",
+               ".##.."],
+    "Ö": [".#.#.", ".....", ".###.", "#...#", "#...#", "#...#", ".###.",
+               "....."],
+    "Ü": [".#.#.", ".....", "#...#", "#...#", "#...#", "#...#", ".###.",
+               "....."],
+    "à": [".#...", "..#..", ".###.", "....#", ".####", "#...#", ".####",
+               "....."],
+    "ç": [".....", ".###.", "#....", "#...#", ".###.", "..#..", ".##..",
+               "....."],
+    "è": [".#...", "..#..", ".###.", "#...#", "#####", "#....", ".###.",
+               "....."],
+    "é": ["...#.", "..#..", ".###.", "#...#", "#####", "#....", ".###.",
+               "....."],
+    "Ω": [".....", ".###.", "#...#", "#...#", "#...#", ".#.#.", "##.##",
+               "....."],
+    "€": ["..##.", ".#..#", "###..", ".#...", "###..", ".#..#", "..##.",
+               "....."],
+    # Central European letters, the marks take the top two rows and the
+    # capitals shrink to five rows like the lower case letters
+    "Á": ["...#.", "..#..", ".###.", "#...#", "#####", "#...#", "#...#",
+           "....."],
+    "Č": [".#.#.", "..#..", ".###.", "#...#", "#....", "#...#", ".###.",
+           "....."],
+    "Ď": [".#.#.", "..#..", "###..", "#..#.", "#...#", "#..#.", "###..",
+           "....."],
+    "É": ["...#.", "..#..", "#####", "#....", "####.", "#....", "#####",
+           "....."],
+    "Ě": [".#.#.", "..#..", "#####", "#....", "####.", "#....", "#####",
+           "....."],
+    "Í": ["...#.", "..#..", ".###.", "..#..", "..#..", "..#..", ".###.",
+           "....."],
+    "Ĺ": ["...#.", "..#..", "#....", "#....", "#....", "#....", "#####",
+           "....."],
+    "Ľ": ["#..#.", "#..#.", "#....", "#....", "#....", "#....", "#####",
+           "....."],
+    "Ň": [".#.#.", "..#..", "#...#", "##..#", "#.#.#", "#..##", "#...#",
+           "....."],
+    "Ó": ["...#.", "..#..", ".###.", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "Ô": ["..#..", ".#.#.", ".###.", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "Ŕ": ["...#.", "..#..", "####.", "#...#", "####.", "#..#.", "#...#",
+           "....."],
+    "Ř": [".#.#.", "..#..", "####.", "#...#", "####.", "#..#.", "#...#",
+           "....."],
+    "Š": [".#.#.", "..#..", ".####", "#....", ".###.", "....#", "####.",
+           "....."],
+    "Ť": [".#.#.", "..#..", "#####", "..#..", "..#..", "..#..", "..#..",
+           "....."],
+    "Ú": ["...#.", "..#..", "#...#", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "Ů": ["..#..", ".#.#.", "..#..", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "Ý": ["...#.", "..#..", "#...#", "#...#", ".#.#.", "..#..", "..#..",
+           "....."],
+    "Ž": [".#.#.", "..#..", "#####", "...#.", "..#..", ".#...", "#####",
+           "....."],
+    "á": ["...#.", "..#..", ".###.", "....#", ".####", "#...#", ".####",
+           "....."],
+    "č": [".#.#.", "..#..", ".###.", "#....", "#....", "#...#", ".###.",
+           "....."],
+    "ď": ["...##", "...##", ".###.", "#..#.", "#..#.", "#..#.", ".###.",
+           "....."],
+    "ě": [".#.#.", "..#..", ".###.", "#...#", "#####", "#....", ".###.",
+           "....."],
+    "í": ["...#.", "..#..", ".##..", "..#..", "..#..", "..#..", ".###.",
+           "....."],
+    "ĺ": ["...#.", "..#..", ".##..", "..#..", "..#..", "..#..", ".###.",
+           "....."],
+    "ľ": [".##.#", "..#.#", "..#..", "..#..", "..#..", "..#..", ".###.",
+           "....."],
+    "ň": [".#.#.", "..#..", "#.##.", "##..#", "#...#", "#...#", "#...#",
+           "....."],
+    "ó": ["...#.", "..#..", ".###.", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "ô": ["..#..", ".#.#.", ".###.", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "ŕ": ["...#.", "..#..", "#.##.", "##..#", "#....", "#....", "#....",
+           "....."],
+    "ř": [".#.#.", "..#..", "#.##.", "##..#", "#....", "#....", "#....",
+           "....."],
+    "š": [".#.#.", "..#..", ".###.", "#....", ".###.", "....#", "####.",
+           "....."],
+    "ť": [".#..#", ".#..#", "###..", ".#...", ".#...", ".#..#", "..##.",
+           "....."],
+    "ú": ["...#.", "..#..", "#...#", "#...#", "#...#", "#..##", ".##.#",
+           "....."],
+    "ů": ["..#..", ".#.#.", "..#..", "#...#", "#...#", "#..##", ".##.#",
+           "....."],
+    "ý": ["...#.", "..#..", "#...#", "#...#", ".####", "....#", ".###.",
+           "....."],
+    "ž": [".#.#.", "..#..", "#####", "...#.", "..#..", ".#...", "#####",
+           "....."],
+    "Ą": [".###.", "#...#", "#...#", "#####", "#...#", "#...#", "...#.",
+           "...##"],
+    "Ć": ["...#.", "..#..", ".###.", "#...#", "#....", "#...#", ".###.",
+           "....."],
+    "Ę": ["#####", "#....", "#....", "####.", "#....", "#####", "...#.",
+           "...##"],
+    "Ł": ["#....", "#....", "#.#..", "##...", "#....", "#....", "#####",
+           "....."],
+    "Ń": ["...#.", "..#..", "#...#", "##..#", "#.#.#", "#..##", "#...#",
+           "....."],
+    "Ś": ["...#.", "..#..", ".####", "#....", ".###.", "....#", "####.",
+           "....."],
+    "Ź": ["...#.", "..#..", "#####", "...#.", "..#..", ".#...", "#####",
+           "....."],
+    "Ż": ["..#..", ".....", "#####", "...#.", "..#..", ".#...", "#####",
+           "....."],
+    "ą": [".....", ".###.", "....#", ".####", "#...#", ".####", "...#.",
+           "...##"],
+    "ć": ["...#.", "..#..", ".###.", "#....", "#....", "#...#", ".###.",
+           "....."],
+    "ę": [".....", ".###.", "#...#", "#####", "#....", ".###.", "..#..",
+           "..##."],
+    "ł": [".##..", "..#..", "..#.#", "..##.", ".##..", "..#..", ".###.",
+           "....."],
+    "ń": ["...#.", "..#..", "#.##.", "##..#", "#...#", "#...#", "#...#",
+           "....."],
+    "ś": ["...#.", "..#..", ".###.", "#....", ".###.", "....#", "####.",
+           "....."],
+    "ź": ["...#.", "..#..", "#####", "...#.", "..#..", ".#...", "#####",
+           "....."],
+    "ż": ["..#..", ".....", "#####", "...#.", "..#..", ".#...", "#####",
+           "....."],
+    "Ő": ["..#.#", ".#.#.", ".###.", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "Ű": ["..#.#", ".#.#.", "#...#", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "ő": ["..#.#", ".#.#.", ".###.", "#...#", "#...#", "#...#", ".###.",
+           "....."],
+    "ű": ["..#.#", ".#.#.", "#...#", "#...#", "#...#", "#..##", ".##.#",
+           "....."],
+}
+
+# ASCII replacements besides the base letters of accented characters.
+TRANSLITERATIONS = {
+    " ": " ", "¡": "!", "¢": "c", "£": "L",
+    "¥": "Y", "§": "S", "©": "C", "«": "<<",
+    "®": "R", "°": "o", "±": "+-", "²": "2",
+    "³": "3", "µ": "u", "·": ".", "¹": "1",
+    "»": ">>", "¿": "?", "Æ": "AE", "Ð": "D",
+    "×": "x", "Ø": "O", "Þ": "Th", "ß": "ss",
+    "æ": "ae", "ð": "d", "÷": ":", "ø": "o",
+    "þ": "th", "Đ": "D", "đ": "d", "ı": "i",
+    "Ł": "L", "ł": "l", "Œ": "OE", "œ": "oe",
+    "Ω": "O", "μ": "u", "π": "p", "–": "-",
+    "—": "-", "‘": "'", "’": "'", "‚": "'",
+    "“": "\"", "”": "\"", "„": "\"", "•": ".",
+    "…": "..", "′": "'", "″": "\"", "€": "E",
+    "Ω": "O", "←": "<", "→": ">", "↑": "^",
+    "↓": "v", "≤": "<", "≥": ">",
+}
+
+
+def katakana_a00():
+    """Maps full-width katakana and hiragana to half-width ROM codes."""
+    table = {}
+    halfwidth = {}
+    for code in range(0xA6, 0xE0):
+        char = chr(0xFF61 + code - 0xA1)
+        halfwidth[unicodedata.normalize("NFKC", char)] = code
+    marks = {"゙": 0xDE, "゚": 0xDF}
+    # letters without a half-width form, replaced by the closest one
+    similar = {"ヮ": "ワ", "ヰ": "イ", "ヱ": "エ",
+               "ヵ": "カ", "ヶ": "ケ"}
+    for cp in range(0x30A1, 0x30FB):
+        char = similar.get(chr(cp), chr(cp))
+        codes = []
+        for part in unicodedata.normalize("NFD", char):
+            if part in halfwidth:
+                codes.append(halfwidth[part])
+            elif part in marks:
+                codes.append(marks[part])
+            else:
+                codes = None
+                break
+        if codes:
+            table[chr(cp)] = codes
+            if 0x30A1 <= cp <= 0x30F6:
+                # hiragana are shown in katakana
+                table.setdefault(chr(cp - 0x60), codes)
+    return table
+
+
+def transliterations():
+    table = {char: [ord(c) for c in text]
+             for char, text in TRANSLITERATIONS.items()}
+    for cp in range(0xC0, 0x250):
+        base = unicodedata.normalize("NFD", chr(cp))[0]
+        if chr(cp) not in table and base != chr(cp) and ord(base) < 0x80:
+            table[chr(cp)] = [ord(base)]
+    return table
+
+
+def rom_table(name, mapping, comment):
+    lines = ["// %s" % comment,
+             "static const _LCD_RomEntry %s[] = {" % name]
+    entries = ["{0x%04X, {0x%02X, 0x%02X}}" %
+               (ord(char), codes[0], codes[1] if len(codes) > 1 else 0)
+               for char, codes in sorted(mapping.items())]
+    line = "   "
+    for entry in entries:
+        if len(line) + len(entry) + 2 > 80:
+            lines.append(line)
+            line = "   "
+        line += " " + entry + ","
+    lines.append(line)
+    lines.append("};")
+    return lines
+
+
+def glyph_table():
+    lines = ["// Bitmaps drawn into CGRAM for characters missing from the ROM",
+             "static const _LCD_Glyph _lcd_glyphs[] = {"]
+    for char, rows in sorted(GLYPHS.items()):
+        assert len(rows) == 8
+        values = ", ".join("0x%02X" % int(row.replace("#", "1")
+                                          .replace(".", "0"), 2)
+                           for row in rows)
+        lines.append("    {0x%04X, {%s}}," % (ord(char), values))
+    lines.append("};")
+    return lines
+
+
+def generate():
+    for mapping in (ROM_A00, ROM_A02):
+        for char, code in mapping.items():
+            mapping[char] = [code]
+    a00 = katakana_a00()
+    a00.update(ROM_A00)
+    for char in GLYPHS:
+        assert len(char) == 1
+    lines = ["// BEGIN lcd_romgen.py, generated by tools/lcd_romgen.py",
+             ""]
+    lines += rom_table("_lcd_rom_a00", a00,
+                       "A00 (Japanese) ROM codes of non-ASCII characters")
+    lines.append("")
+    lines += rom_table("_lcd_rom_a02", ROM_A02,
+                       "A02 (European) ROM codes of non-ASCII characters")
+    lines.append("")
+    lines += glyph_table()
+    lines.append("")
+    lines += rom_table("_lcd_transliterations", transliterations(),
+                       "ASCII replacements if neither ROM nor CGRAM can help")
+    lines.append("")
+    lines.append("// END lcd_romgen.py")
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--update", metavar="SOURCE",
+                        help="replace the tables in this source file")
+    args = parser.parse_args()
+    lines = generate()
+    if not args.update:
+        print("\n".join(lines))
+        return
+    with open(args.update) as source:
+        text = source.read().split("\n")
+    begin = [i for i, line in enumerate(text)
+             if line.startswith("// BEGIN lcd_romgen.py")]
+    end = [i for i, line in enumerate(text)
+           if line.startswith("// END lcd_romgen.py")]
+    if len(begin) != 1 or len(end) != 1 or end[0] < begin[0]:
+        sys.exit("%s: no generated tables found" % args.update)
+    text[begin[0]:end[0] + 1] = lines
+    with open(args.update, "w") as source:
+        source.write("\n".join(text))
+
+
+if __name__ == "__main__":
+    main()
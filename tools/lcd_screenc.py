@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2024 Jozef Kromka <jozef.kromka22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+#
+"""Compile screen layouts into command streams for lcd_replay().
+
+Usage: lcd_screenc.py layout.txt [-o screens] [--bus 4|8]
+
+Writes screens.c and screens.h with one pre-encoded stream per screen and an
+LCD_StreamField for every field, so the firmware only patches the fields
+(lcd_stream_patch()) and replays the stream, or just the changed fields
+(lcd_replay_field()), instead of formatting and sending the whole screen. The
+layout file looks like this:
+
+    # comments start with '#'
+    display 16x2
+
+    # custom character 0-7: 8 rows of 5 pixels, '#' is on, '.' is off
+    glyph 0
+    .###.
+    .#.#.
+    .###.
+    .....
+    .....
+    .....
+    .....
+    .....
+
+    # one line per row between '|'; {name:width} is a field, \\0-\\7 a custom
+    # character, \\xNN any other character code, \\\\, \\| and \\{ are literal
+    screen status
+    |Temp {temp:5}\\0C  |
+    |Menu >          |
+
+Rows that are left out stay blank. Custom characters are uploaded by the
+streams of the screens that use them.
+"""
+
+import argparse
+import re
+import sys
+
+# Stream format, see LCD_STREAM_4BIT in LCD_HD44780U.h
+LCD_STREAM_4BIT = 0x04
+LCD_STREAM_8BIT = 0x08
+LCD_STREAM_RS = 0x10
+LCD_STREAM_WAIT = 0x80
+LCD_STREAM_WAIT_UNIT_US = 64
+
+LCD_CLEARDISPLAY = 0x01
+LCD_ENTRYMODESET_LEFT = 0x06
+LCD_SETCGRAMADDR = 0x40
+LCD_SETDDRAMADDR = 0x80
+
+# execution time of the clear instruction waited for by lcd_clear()
+CLEAR_US = 5000
+
+FIELD = re.compile(r"\{([A-Za-z_][A-Za-z0-9_]*):([0-9]+)\}")
+IDENTIFIER = re.compile(r"[A-Za-z_][A-Za-z0-9_]*$")
+
+
+class LayoutError(Exception):
+    pass
+
+
+class Screen:
+    def __init__(self, name, line):
+        self.name = name
+        self.line = line
+        self.rows = []
+        # (name, col, row, width)
+        self.fields = []
+
+
+def parse_row(text, number, cols, row, screen):
+    """Returns the character codes of a row, fields filled with spaces."""
+    cells = []
+    i = 0
+    while i < len(text):
+        char = text[i]
+        if char == "{":
+            match = FIELD.match(text, i)
+            if not match:
+                raise LayoutError("line %d: bad field, use {name:width}" %
+                                  number)
+            width = int(match.group(2))
+            if width == 0:
+                raise LayoutError("line %d: field of width 0" % number)
+            screen.fields.append((match.group(1), len(cells), row, width))
+            cells.extend([0x20] * width)
+            i = match.end()
+            continue
+        if char == "\\":
+            escape = text[i + 1:i + 2]
+            if escape in ("0", "1", "2", "3", "4", "5", "6", "7"):
+                cells.append(int(escape))
+                i += 2
+            elif escape == "x" and re.match(r"[0-9A-Fa-f]{2}",
+                                            text[i + 2:i + 4]):
+                cells.append(int(text[i + 2:i + 4], 16))
+                i += 4
+            elif escape in ("\\", "|", "{"):
+                cells.append(ord(escape))
+                i += 2
+            else:
+                raise LayoutError("line %d: bad escape '\\%s'" %
+                                  (number, escape))
+            continue
+        if ord(char) > 0x7E:
+            raise LayoutError("line %d: '%s' is not ASCII, use \\xNN" %
+                              (number, char))
+        cells.append(ord(char))
+        i += 1
+    if len(cells) > cols:
+        raise LayoutError("line %d: row is %d characters, display has %d" %
+                          (number, len(cells), cols))
+    return cells + [0x20] * (cols - len(cells))
+
+
+def parse(lines):
+    """Returns (cols, rows, glyphs, screens) of a layout file."""
+    cols = rows = None
+    glyphs = {}
+    screens = []
+    glyph = None
+    screen = None
+    for number, raw in enumerate(lines, 1):
+        line = raw.rstrip("\r\n")
+        if glyph is not None:
+            num, pattern, start = glyph
+            row = line.strip()
+            if not re.match(r"[#.]{5}$", row):
+                raise LayoutError("line %d: glyph rows are 5 of '#' or '.'" %
+                                  number)
+            pattern.append(int(row.replace("#", "1").replace(".", "0"), 2))
+            if len(pattern) == 8:
+                glyphs[num] = pattern
+                glyph = None
+            continue
+        if line.startswith("|"):
+            if screen is None:
+                raise LayoutError("line %d: row outside of a screen" % number)
+            if not line.rstrip().endswith("|") or len(line.rstrip()) < 2:
+                raise LayoutError("line %d: rows end with '|'" % number)
+            if len(screen.rows) == rows:
+                raise LayoutError("line %d: display has %d rows" %
+                                  (number, rows))
+            screen.rows.append(parse_row(line.rstrip()[1:-1], number, cols,
+                                         len(screen.rows), screen))
+            continue
+        words = line.split("#", 1)[0].split()
+        if not words:
+            continue
+        if words[0] == "display" and len(words) == 2:
+            match = re.match(r"([0-9]+)x([0-9]+)$", words[1])
+            if not match:
+                raise LayoutError("line %d: use display COLSxROWS" % number)
+            cols, rows = int(match.group(1)), int(match.group(2))
+            if not 1 <= cols <= 40 or not 1 <= rows <= 4:
+                raise LayoutError("line %d: unsupported display size" %
+                                  number)
+        elif cols is None:
+            raise LayoutError("line %d: display size must come first" %
+                              number)
+        elif words[0] == "glyph" and len(words) == 2 and \
+                words[1] in "01234567" and len(words[1]) == 1:
+            glyph = (int(words[1]), [], number)
+            screen = None
+        elif words[0] == "screen" and len(words) == 2 and \
+                IDENTIFIER.match(words[1]):
+            screen = Screen(words[1], number)
+            screens.append(screen)
+        else:
+            raise LayoutError("line %d: unknown statement '%s'" %
+                              (number, line.strip()))
+    if glyph is not None:
+        raise LayoutError("line %d: glyph %d has less than 8 rows" %
+                          (glyph[2], glyph[0]))
+    if not screens:
+        raise LayoutError("no screens")
+    for screen in screens:
+        screen.rows += [[0x20] * cols] * (rows - len(screen.rows))
+        names = [field[0] for field in screen.fields]
+        for name in names:
+            if names.count(name) > 1:
+                raise LayoutError("line %d: field '%s' used twice" %
+                                  (screen.line, name))
+        for row in screen.rows:
+            for code in row:
+                if code < 8 and code not in glyphs:
+                    raise LayoutError("line %d: glyph %d is not defined" %
+                                      (screen.line, code))
+    return cols, rows, glyphs, screens
+
+
+class Encoder:
+    """Encodes transfers the same way as lcd_record_begin()."""
+
+    def __init__(self, bus):
+        self.bus = bus
+        self.stream = [LCD_STREAM_8BIT if bus == 8 else LCD_STREAM_4BIT]
+
+    def transfer(self, flags, value):
+        if self.bus == 8:
+            self.stream += [flags, value]
+        else:
+            self.stream += [flags | value >> 4, flags | value & 0x0F]
+
+    def command(self, value):
+        self.transfer(0, value)
+
+    def data(self, value):
+        self.transfer(LCD_STREAM_RS, value)
+
+    def wait(self, us):
+        units = -(-us // LCD_STREAM_WAIT_UNIT_US)
+        while units > 0:
+            chunk = min(units, 127)
+            self.stream.append(LCD_STREAM_WAIT | chunk)
+            units -= chunk
+
+
+def encode(screen, cols, rows, glyphs, bus):
+    """Returns the stream of a screen and the stream offsets of its fields."""
+    encoder = Encoder(bus)
+    encoder.command(LCD_CLEARDISPLAY)
+    encoder.wait(CLEAR_US)
+    encoder.command(LCD_ENTRYMODESET_LEFT)
+    used = sorted(set(code for row in screen.rows for code in row if code < 8))
+    address = None
+    for num in used:
+        if address != num << 3:
+            encoder.command(LCD_SETCGRAMADDR | num << 3)
+        for value in glyphs[num]:
+            encoder.data(value)
+        address = (num + 1) << 3
+    row_offsets = [0x00, 0x40, cols, 0x40 + cols]
+    field_cells = {}
+    for name, col, row, width in screen.fields:
+        for i in range(width):
+            field_cells[(col + i, row)] = (name, i)
+    offsets = {}
+    for row in range(rows):
+        cells = screen.rows[row]
+        # the screen is cleared, so only characters and fields are written,
+        # single spaces between them cost less than setting the address
+        written = [cells[col] != 0x20 or (col, row) in field_cells
+                   for col in range(cols)]
+        for col in range(1, cols - 1):
+            if not written[col] and written[col - 1] and written[col + 1]:
+                written[col] = True
+        address = None
+        for col in range(cols):
+            if not written[col]:
+                address = None
+                continue
+            if address is None:
+                encoder.command(LCD_SETDDRAMADDR | (row_offsets[row] + col))
+                address = col
+            if field_cells.get((col, row), (None, 1))[1] == 0:
+                offsets[field_cells[(col, row)][0]] = len(encoder.stream)
+            encoder.data(cells[col])
+    return encoder.stream, offsets
+
+
+def c_array(values):
+    lines = []
+    for i in range(0, len(values), 12):
+        lines.append("    " + ", ".join("0x%02X" % value
+                                        for value in values[i:i + 12]) + ",")
+    return "\n".join(lines)
+
+
+def write_sources(base, source, cols, rows, glyphs, screens, bus):
+    header_name = base.split("/")[-1] + ".h"
+    guard = "__" + re.sub(r"[^A-Za-z0-9]", "_", header_name).upper() + "__"
+    header = ["// Generated by lcd_screenc.py from %s, do not edit." % source,
+              "", "#ifndef %s" % guard, "#define %s" % guard, "",
+              "#include \"LCD_HD44780U.h\"", ""]
+    code = ["// Generated by lcd_screenc.py from %s, do not edit." % source,
+            "", "#include \"%s\"" % header_name, ""]
+    for screen in screens:
+        stream, offsets = encode(screen, cols, rows, glyphs, bus)
+        # streams with fields are patched at run time, so they live in RAM
+        qualifier = "" if screen.fields else "const "
+        header.append("// Screen \"%s\" for a %dx%d display on a %d-bit bus" %
+                      (screen.name, cols, rows, bus))
+        header.append("extern %suint8_t %s_stream[%d];" %
+                      (qualifier, screen.name, len(stream)))
+        code.append("%suint8_t %s_stream[%d] = {" %
+                    (qualifier, screen.name, len(stream)))
+        code.append(c_array(stream))
+        code.append("};")
+        for name, col, row, width in screen.fields:
+            header.append("extern const LCD_StreamField %s_%s;" %
+                          (screen.name, name))
+            code.append("const LCD_StreamField %s_%s = {%d, %d, %d, %d};" %
+                        (screen.name, name, offsets[name], col, row, width))
+        header.append("")
+        code.append("")
+    header.append("#endif")
+    with open(base + ".h", "w") as out:
+        out.write("\n".join(header) + "\n")
+    with open(base + ".c", "w") as out:
+        out.write("\n".join(code))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("layout", type=argparse.FileType("r"))
+    parser.add_argument("-o", "--output", default="screens",
+                        help="base name of the generated .c and .h files")
+    parser.add_argument("--bus", type=int, choices=(4, 8), default=4,
+                        help="data bus width of the display")
+    args = parser.parse_args()
+    try:
+        cols, rows, glyphs, screens = parse(args.layout)
+    except LayoutError as error:
+        sys.exit("%s: %s" % (args.layout.name, error))
+    write_sources(args.output, args.layout.name.split("/")[-1], cols, rows,
+                  glyphs, screens, args.bus)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+#
+# SPDX-FileCopyrightText: 2024 Jozef Kromka <jozef.kromka22@gmail.com>
+#
+# SPDX-License-Identifier: MIT
+#
+"""Convert an lcd_trace_dump() capture into a VCD file for GTKWave.
+
+Usage: lcd_trace2vcd.py [capture.txt] [-o trace.vcd]
+
+The capture may contain any other console output, only the lines between
+"# lcd-trace v1" and "# lcd-trace end" are used. The VCD contains the RS,
+RW, E and DB7..DB0 signals plus a string signal "instr" with the decoded
+HD44780 instruction of every complete transfer.
+"""
+
+import argparse
+import sys
+
+
+def parse(lines):
+    """Yields (time_us, read, rs, nibble, value) tuples of the last capture."""
+    entries = []
+    inside = False
+    for line in lines:
+        line = line.strip()
+        if line.startswith("# lcd-trace v1"):
+            entries = []
+            inside = True
+            continue
+        if line.startswith("# lcd-trace end"):
+            inside = False
+            continue
+        if not inside or not line or line.startswith("#"):
+            continue
+        fields = line.split()
+        if len(fields) != 5:
+            continue
+        time_us, direction, register, width, value = fields
+        entries.append((int(time_us), direction == "R", register == "D",
+                        width == "4", int(value, 16)))
+    return entries
+
+
+def unwrap(entries):
+    """Turns the 32 bit microsecond timestamps into monotonic ones."""
+    offset = 0
+    previous = None
+    for time_us, *rest in entries:
+        if previous is not None and time_us < previous:
+            offset += 1 << 32
+        previous = time_us
+        yield (time_us + offset, *rest)
+
+
+def decode_instruction(byte):
+    if byte & 0x80:
+        return "SET_DDRAM_0x%02X" % (byte & 0x7F)
+    if byte & 0x40:
+        return "SET_CGRAM_0x%02X" % (byte & 0x3F)
+    if byte & 0x20:
+        return "FUNCTION_SET_%dBIT_%dLINE_5x%d" % (
+            8 if byte & 0x10 else 4, 2 if byte & 0x08 else 1,
+            10 if byte & 0x04 else 8)
+    if byte & 0x10:
+        return "%s_SHIFT_%s" % ("DISPLAY" if byte & 0x08 else "CURSOR",
+                                "RIGHT" if byte & 0x04 else "LEFT")
+    if byte & 0x08:
+        return "DISPLAY_%s_CURSOR_%s_BLINK_%s" % (
+            "ON" if byte & 0x04 else "OFF", "ON" if byte & 0x02 else "OFF",
+            "ON" if byte & 0x01 else "OFF")
+    if byte & 0x04:
+        return "ENTRY_MODE_%s%s" % ("INC" if byte & 0x02 else "DEC",
+                                    "_SHIFT" if byte & 0x01 else "")
+    if byte & 0x02:
+        return "RETURN_HOME"
+    if byte & 0x01:
+        return "CLEAR_DISPLAY"
+    return "NOP"
+
+
+def decode_data(byte):
+    if 0x21 <= byte <= 0x7E and chr(byte) not in "\\'":
+        return "DATA_'%s'" % chr(byte)
+    return "DATA_0x%02X" % byte
+
+
+def decode(entries):
+    """Pairs nibbles like the controller does and yields decoded transfers.
+
+    The controller powers up with an 8-bit interface, so the single nibbles of
+    the 4-bit initialization sequence are decoded as 8-bit function sets until
+    one of them switches the interface to 4 bits.
+    """
+    eight_bit = True
+    high = None
+    for time_us, read, rs, nibble, value in entries:
+        if nibble and eight_bit:
+            value <<= 4
+            nibble = False
+        if nibble:
+            if high is None or high[1:3] != (read, rs):
+                high = (value, read, rs)
+                yield time_us, read, rs, None
+                continue
+            value = (high[0] << 4) | value
+            high = None
+        if read:
+            text = ("READ_0x%02X" % value) if rs else (
+                "BUSY_%d_AC_0x%02X" % (value >> 7, value & 0x7F))
+        elif rs:
+            text = decode_data(value)
+        else:
+            text = decode_instruction(value)
+            if value & 0xE0 == 0x20:
+                eight_bit = bool(value & 0x10)
+        yield time_us, read, rs, text
+
+
+def write_vcd(entries, out):
+    out.write("$timescale 1us $end\n")
+    out.write("$scope module lcd $end\n")
+    out.write("$var wire 1 r RS $end\n")
+    out.write("$var wire 1 w RW $end\n")
+    out.write("$var wire 1 e E $end\n")
+    out.write("$var wire 8 d DB $end\n")
+    out.write("$var string 1 i instr $end\n")
+    out.write("$upscope $end\n$enddefinitions $end\n")
+    out.write("#0\n$dumpvars\n0r\n0w\n0e\nb0 d\nsidle i\n$end\n")
+    decoded = decode(entries)
+    last = -2
+    for (time_us, read, rs, nibble, value), (_, _, _, text) in zip(entries,
+                                                                decoded):
+        # Every transfer is drawn as a 1 us ENABLE pulse ending at its
+        # timestamp, pushed later if transfers were recorded back to back.
+        start = max(time_us - 1, last + 1)
+        bus = value << 4 if nibble else value
+        out.write("#%d\n%dr\n%dw\n1e\nb%s d\n" %
+                  (start, int(rs), int(read), format(bus, "b")))
+        out.write("#%d\n0e\n" % (start + 1))
+        if text is not None:
+            out.write("s%s i\n" % text)
+        last = start + 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("capture", nargs="?", type=argparse.FileType("r"),
+                        default=sys.stdin)
+    parser.add_argument("-o", "--output", type=argparse.FileType("w"),
+                        default=sys.stdout)
+    args = parser.parse_args()
+    entries = list(unwrap(parse(args.capture)))
+    if not entries:
+        sys.exit("no lcd-trace capture found")
+    write_vcd(entries, args.output)
+
+
+if __name__ == "__main__":
+    main()